@@ -22,7 +22,33 @@ gulp.task('watch',function(){
 
 gulp.task('build', shell.task(['pebble build']));
 
+// same as build, but with debug logging compiled out; see src/cgm_log.h
+gulp.task('build-release', shell.task(['CGM_BUILD=release pebble build']));
+
+// host builds of the platform independent modules against test/pebble.h; see test/Makefile
+gulp.task('test', shell.task(['make -C test test']));
+
+gulp.task('bench', shell.task(['make -C test bench']));
+
 gulp.task('install', shell.task(['pebble install --phone ' + developerIpAddress])); 
 
+// rebuilds resources/images/trends.png from the individual trend icons
+gulp.task('trend-atlas', function (done) {
+	require('./tools/trend-atlas.js')();
+	done();
+});
+
+// rebuilds resources/images/bg_glyphs.png and src/bg_glyph_table.h, the pre-rendered BG reading glyphs
+gulp.task('bg-glyphs', function (done) {
+	require('./tools/bg-glyphs.js')();
+	done();
+});
+
+// rebuilds resources/images/trends.pdc, the vector trend glyphs used on colour platforms
+gulp.task('trend-pdc', function (done) {
+	require('./tools/trend-pdc.js')();
+	done();
+});
+
 gulp.task('default', gulp.series("build", "install", "watch"));
 
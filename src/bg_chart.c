@@ -0,0 +1,48 @@
+#include "bg_chart.h"
+#include "bg_history.h"
+
+// The readings handed to the chart, which copies them
+static int s_bgs[BG_HISTORY_CAPACITY];
+static int s_bg_times[BG_HISTORY_CAPACITY];
+static int s_num_bgs = 0;
+
+bool bg_chart_apply_packet(ChartLayer *chart, const BgPacket *packet) {
+    bool full = packet->flags & BG_PACKET_FLAG_FULL;
+    if (full) {
+        bg_history_clear();
+    } else if (bg_history_count() == 0) {
+        // nothing to append to; the next request will ask for a full resync
+        return false;
+    }
+
+    // records arrive newest first, so walk them backwards to append in time order
+    for (int n = packet->count - 1; n >= 0; n -= 1) {
+        uint16_t minutes;
+        int16_t mgdl;
+        bg_packet_get(packet, n, &minutes, &mgdl);
+        uint32_t time = packet->newest - minutes * 60;
+        if (bg_history_append(time, mgdl) && !full && chart) {
+            chart_layer_append_point(chart, time / 60, mgdl);
+        }
+    }
+    return full;
+}
+
+static bool chart_point(const BgRecord *record, void *context) {
+    s_bg_times[s_num_bgs] = record->time / 60;
+    s_bgs[s_num_bgs] = record->mgdl;
+    s_num_bgs++;
+    return true;
+}
+
+void bg_chart_refresh(ChartLayer *chart) {
+    if (!chart) {
+        return;
+    }
+    const BgRecord *latest = bg_history_latest();
+    s_num_bgs = 0;
+    if (latest) {
+        bg_history_foreach(latest->time - BG_CHART_WINDOW_MINUTES * 60 + 1, latest->time, chart_point, NULL);
+    }
+    chart_layer_set_data(chart, s_bg_times, eINT, s_bgs, eINT, s_num_bgs);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pebble.h>
+#include "bg_packet.h"
+#include "pebble_chart.h"
+
+//! Keeps the spark line in step with bg_history as history packets come in
+//! from the phone.
+//!
+//! The chart's x-axis is minutes since the epoch, so readings appended to the
+//! history can be appended to the chart as they are, without laying out the
+//! readings already shown.
+
+//! How far back the chart goes, in minutes.
+#define BG_CHART_WINDOW_MINUTES 180
+
+//! Merges a history packet from the phone into bg_history. A full packet
+//! replaces the history; the readings of any other packet are appended, to
+//! the chart as well.
+//! @param chart The chart showing the history, may be NULL.
+//! @param packet The packet to merge.
+//! @return true if the chart has to be rebuilt with bg_chart_refresh.
+bool bg_chart_apply_packet(ChartLayer *chart, const BgPacket *packet);
+
+//! Hands all readings within the chart window to the chart. Only needed when
+//! the history is replaced; new readings are appended by
+//! bg_chart_apply_packet.
+//! @param chart The chart to refresh, may be NULL.
+void bg_chart_refresh(ChartLayer *chart);
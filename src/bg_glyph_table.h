@@ -0,0 +1,12 @@
+// Generated by tools/bg-glyphs.js from HelveticaNeueBold.ttf at 48px; do not edit.
+#pragma once
+
+#define BG_GLYPH_CHARS "0123456789.?dghlow"
+#define BG_GLYPH_COUNT 18
+#define BG_GLYPH_CELL_WIDTH 39
+#define BG_GLYPH_CELL_HEIGHT 46
+
+//! The advance of each glyph in BG_GLYPH_CHARS, in pixels.
+static const uint8_t BG_GLYPH_ADVANCES[BG_GLYPH_COUNT] = {
+    27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 13, 27, 29, 29, 28, 12, 29, 39
+};
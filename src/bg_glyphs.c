@@ -0,0 +1,99 @@
+#include "bg_glyphs.h"
+#include "bg_glyph_table.h"
+
+// The whole atlas, one cell of BG_GLYPH_CELL_WIDTH x BG_GLYPH_CELL_HEIGHT per glyph, stacked vertically
+static GBitmap *s_atlas = NULL;
+// A single sub-bitmap of the atlas that is pointed at each glyph in turn
+static GBitmap *s_glyph = NULL;
+#ifdef PBL_COLOR
+static GColor s_tint;
+#endif
+
+static int glyph_index(char c) {
+    const char *found = strchr(BG_GLYPH_CHARS, c);
+    return (c && found) ? found - BG_GLYPH_CHARS : -1;
+}
+
+void bg_glyphs_load(void) {
+#ifdef PBL_COLOR
+    s_atlas = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BG_GLYPHS);
+    s_tint = GColorWhite;
+#else
+    s_atlas = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BG_GLYPHS_WHITE);
+#endif
+    s_glyph = s_atlas ? gbitmap_create_as_sub_bitmap(s_atlas, GRect(0, 0, BG_GLYPH_CELL_WIDTH, BG_GLYPH_CELL_HEIGHT))
+                      : NULL;
+}
+
+void bg_glyphs_unload(void) {
+    if (s_glyph) {
+        gbitmap_destroy(s_glyph);
+        s_glyph = NULL;
+    }
+    if (s_atlas) {
+        gbitmap_destroy(s_atlas);
+        s_atlas = NULL;
+    }
+}
+
+bool bg_glyphs_can_draw(const char *text) {
+    if (!s_glyph || !text || !*text) {
+        return false;
+    }
+    for (; *text; text++) {
+        if (glyph_index(*text) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef PBL_COLOR
+/**
+ * Recolours the opaque entries of the atlas palette, which the glyph sub-bitmap shares, so the glyphs can be copied
+ * straight onto the alert box in the colour of the current state.
+ */
+static void tint(GColor ink) {
+    if (gcolor_equal(ink, s_tint)) {
+        return;
+    }
+    GColor *palette = gbitmap_get_palette(s_glyph);
+    int size = 0;
+    switch (gbitmap_get_format(s_glyph)) {
+        case GBitmapFormat1BitPalette: size = 2; break;
+        case GBitmapFormat2BitPalette: size = 4; break;
+        case GBitmapFormat4BitPalette: size = 16; break;
+        default: break;
+    }
+    for (int i = 0; palette && i < size; i++) {
+        if (palette[i].a) {
+            palette[i] = ink;
+        }
+    }
+    s_tint = ink;
+}
+#endif
+
+void bg_glyphs_draw(GContext *ctx, GRect bounds, const char *text, GColor ink) {
+    int width = 0;
+    for (const char *c = text; *c; c++) {
+        width += BG_GLYPH_ADVANCES[glyph_index(*c)];
+    }
+
+#ifdef PBL_COLOR
+    tint(ink);
+    graphics_context_set_compositing_mode(ctx, GCompOpSet);
+#else
+    // the glyphs are white: OR them in for white, clear them out for black
+    graphics_context_set_compositing_mode(ctx, gcolor_equal(ink, GColorWhite) ? GCompOpOr : GCompOpClear);
+#endif
+
+    int x = bounds.origin.x + (bounds.size.w - width) / 2;
+    for (; *text; text++) {
+        int index = glyph_index(*text);
+        int advance = BG_GLYPH_ADVANCES[index];
+        gbitmap_set_bounds(s_glyph, GRect(0, index * BG_GLYPH_CELL_HEIGHT, advance, BG_GLYPH_CELL_HEIGHT));
+        graphics_draw_bitmap_in_rect(ctx, s_glyph, GRect(x, bounds.origin.y, advance, BG_GLYPH_CELL_HEIGHT));
+        x += advance;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pebble.h>
+
+//! Draws the BG reading from glyphs pre-rendered by tools/bg-glyphs.js, one
+//! bitmap copy per character, instead of through the text engine.
+//!
+//! The glyphs cover the digits, '.', '?' and the letters of the status words
+//! the phone sends in place of a reading; text with any other character has
+//! to be drawn with the font instead, see bg_glyphs_can_draw.
+
+//! Loads the glyph atlas. Call once before drawing.
+void bg_glyphs_load(void);
+
+//! Frees the glyph atlas.
+void bg_glyphs_unload(void);
+
+//! @param text The text to check.
+//! @return true if the atlas is loaded and has a glyph for every character
+//! of `text`.
+bool bg_glyphs_can_draw(const char *text);
+
+//! Draws `text` centred horizontally along the top of `bounds`, in the same
+//! place a centred text layer would put it.
+//! @param ctx The graphics context to draw into.
+//! @param bounds The box to centre the text in.
+//! @param text The text to draw, which bg_glyphs_can_draw must accept.
+//! @param ink The colour to draw in; aplite only has black and white.
+void bg_glyphs_draw(GContext *ctx, GRect bounds, const char *text, GColor ink);
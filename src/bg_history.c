@@ -0,0 +1,70 @@
+#include "bg_history.h"
+
+#define INDEX_MASK (BG_HISTORY_CAPACITY - 1)
+
+_Static_assert((BG_HISTORY_CAPACITY & INDEX_MASK) == 0, "BG_HISTORY_CAPACITY must be a power of two");
+
+// Statically allocated so the heap stays flat no matter how long the face runs.
+// s_head is the slot the next reading goes into; the oldest reading sits
+// s_count slots before it.
+static BgRecord s_records[BG_HISTORY_CAPACITY];
+static uint16_t s_head = 0;
+static uint16_t s_count = 0;
+
+/**
+ * Maps a position counted from the oldest reading to its slot in the ring.
+ */
+static const BgRecord* record_at(uint16_t position) {
+    return &s_records[(s_head - s_count + position) & INDEX_MASK];
+}
+
+void bg_history_clear(void) {
+    s_head = 0;
+    s_count = 0;
+}
+
+bool bg_history_append(uint32_t time, int16_t mgdl) {
+    const BgRecord *latest = bg_history_latest();
+    if (latest && time <= latest->time) {
+        return false;
+    }
+
+    s_records[s_head] = (BgRecord) { .time = time, .mgdl = mgdl };
+    s_head = (s_head + 1) & INDEX_MASK;
+    if (s_count < BG_HISTORY_CAPACITY) {
+        s_count++;
+    }
+    return true;
+}
+
+uint16_t bg_history_count(void) {
+    return s_count;
+}
+
+const BgRecord* bg_history_latest(void) {
+    return s_count ? &s_records[(s_head - 1) & INDEX_MASK] : NULL;
+}
+
+const BgRecord* bg_history_at(uint16_t index) {
+    return (index < s_count) ? record_at(index) : NULL;
+}
+
+void bg_history_foreach(uint32_t from, uint32_t to, BgHistoryCallback callback, void *context) {
+    // readings are in time order, so binary search for the first one at or after `from`
+    uint16_t lo = 0, hi = s_count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (record_at(mid)->time < from) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (uint16_t position = lo; position < s_count; position++) {
+        const BgRecord *record = record_at(position);
+        if (record->time > to || !callback(record, context)) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <pebble.h>
+
+//! Number of readings kept on the watch. Must be a power of two.
+//! At one reading every 5 minutes, 64 covers ~5 hours and 256 ~21 hours.
+#if defined(PBL_PLATFORM_APLITE)
+#define BG_HISTORY_CAPACITY 64
+#else
+#define BG_HISTORY_CAPACITY 256
+#endif
+
+//! A single glucose reading.
+typedef struct {
+    uint32_t time;
+    int16_t mgdl;
+} BgRecord;
+
+//! Called for each reading visited by bg_history_foreach.
+//! @param record The reading, only valid for the duration of the call.
+//! @param context The context passed to bg_history_foreach.
+//! @return true to continue iterating, false to stop.
+typedef bool (*BgHistoryCallback)(const BgRecord *record, void *context);
+
+//! Removes all readings from the history.
+void bg_history_clear(void);
+
+//! Appends a reading to the history in O(1), overwriting the oldest reading
+//! once the history is full. Readings are kept in time order, so a reading
+//! that is not newer than the latest one is a duplicate and is dropped.
+//! @param time The time of the reading, seconds since the epoch.
+//! @param mgdl The glucose value in mg/dL.
+//! @return true if the reading was added.
+bool bg_history_append(uint32_t time, int16_t mgdl);
+
+//! @return The number of readings held.
+uint16_t bg_history_count(void);
+
+//! @return The newest reading, or NULL if the history is empty.
+const BgRecord* bg_history_latest(void);
+
+//! Random access into the history in O(1).
+//! @param index The reading to get, 0 being the oldest.
+//! @return The reading, or NULL if `index` is out of range.
+const BgRecord* bg_history_at(uint16_t index);
+
+//! Visits, oldest first, every reading with a time in [from, to].
+//! @param from The earliest time to visit, inclusive.
+//! @param to The latest time to visit, inclusive.
+//! @param callback The function to call for each reading.
+//! @param context Passed through to the callback.
+void bg_history_foreach(uint32_t from, uint32_t to, BgHistoryCallback callback, void *context);
@@ -0,0 +1,40 @@
+#include "bg_packet.h"
+
+/**
+ * Tuple buffers carry no alignment guarantee, so read fields a byte at a time.
+ */
+static uint16_t read_u16(const uint8_t *p) {
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32(const uint8_t *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+bool bg_packet_parse(BgPacket *packet, const Tuple *tuple) {
+    if (!packet || !tuple || tuple->type != TUPLE_BYTE_ARRAY || tuple->length < BG_PACKET_HEADER_SIZE) {
+        return false;
+    }
+
+    const uint8_t *data = tuple->value->data;
+    if (data[0] != BG_PACKET_VERSION) {
+        return false;
+    }
+
+    uint8_t count = data[1];
+    if (tuple->length < BG_PACKET_HEADER_SIZE + count * BG_PACKET_RECORD_SIZE) {
+        return false;
+    }
+
+    packet->count = count;
+    packet->flags = data[2];
+    packet->newest = read_u32(&data[4]);
+    packet->records = &data[BG_PACKET_HEADER_SIZE];
+    return true;
+}
+
+void bg_packet_get(const BgPacket *packet, uint8_t index, uint16_t *minutes, int16_t *mgdl) {
+    const uint8_t *record = packet->records + index * BG_PACKET_RECORD_SIZE;
+    *minutes = read_u16(record);
+    *mgdl = (int16_t) read_u16(record + 2);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <pebble.h>
+
+//! Binary wire format for the BG history sent by the phone in the `bgs` key.
+//!
+//! All multi-byte fields are little-endian.
+//!
+//!     offset  size  field
+//!     0       1     version (BG_PACKET_VERSION)
+//!     1       1     number of records that follow
+//!     2       1     flags (BG_PACKET_FLAG_*)
+//!     3       1     reserved (0)
+//!     4       4     time of the newest reading, seconds since the epoch
+//!     8       4*n   records, newest first:
+//!                     uint16 minutes before the newest reading
+//!                     int16  glucose value in mg/dL
+//!
+//! Unless BG_PACKET_FLAG_FULL is set, the packet only holds the readings newer
+//! than the `since` time the watch sent with its request and is appended to
+//! the history the watch already holds.
+#define BG_PACKET_VERSION 2
+#define BG_PACKET_HEADER_SIZE 8
+#define BG_PACKET_RECORD_SIZE 4
+
+//! The packet replaces the watch's history rather than extending it.
+#define BG_PACKET_FLAG_FULL 0x01
+
+//! A validated view onto a history packet. It points into the Tuple it was
+//! parsed from and is only valid for as long as that Tuple is.
+typedef struct {
+    const uint8_t *records;
+    uint8_t count;
+    uint8_t flags;
+    uint32_t newest;
+} BgPacket;
+
+//! Validates the header of a `bgs` tuple and fills in a view onto its records.
+//! No data is copied and nothing is allocated.
+//! @param packet The BgPacket to fill in.
+//! @param tuple The tuple received from the phone, may be null.
+//! @return true if the tuple holds a well formed packet of a known version.
+bool bg_packet_parse(BgPacket *packet, const Tuple *tuple);
+
+//! Reads a single record straight out of the packet buffer.
+//! @param packet A packet previously filled in by bg_packet_parse.
+//! @param index The record to read, 0 being the newest.
+//! @param minutes Out: minutes between this reading and the newest one.
+//! @param mgdl Out: the glucose value in mg/dL.
+void bg_packet_get(const BgPacket *packet, uint8_t index, uint16_t *minutes, int16_t *mgdl);
@@ -0,0 +1,163 @@
+#include "bg_store.h"
+#include "bg_history.h"
+
+// Persist keys. SNOOZE_KEY (1) lives in main.c; the store keeps to its own range.
+#define KEY_BASE 0x100
+#define KEYS_PER_SLOT 0x10
+#define NUM_SLOTS 2
+
+#define RECORDS_PER_CHUNK (PERSIST_DATA_MAX_LENGTH / sizeof(StoredRecord))
+#define NUM_CHUNKS ((BG_STORE_MAX_RECORDS + RECORDS_PER_CHUNK - 1) / RECORDS_PER_CHUNK)
+
+// A reading as stored on flash, relative to the newest reading of the snapshot.
+typedef struct {
+    uint16_t minutes;
+    int16_t mgdl;
+} StoredRecord;
+
+typedef struct {
+    uint8_t version;
+    uint8_t num_records;
+    uint8_t trend;
+    uint8_t alert;
+    uint32_t generation;
+    uint32_t newest;
+    uint32_t checksum;
+    char egv[BG_STORE_EGV_LENGTH];
+    char delta[BG_STORE_DELTA_LENGTH];
+} StoreHeader;
+
+_Static_assert(sizeof(StoreHeader) <= PERSIST_DATA_MAX_LENGTH, "StoreHeader must fit in one persist record");
+_Static_assert(NUM_CHUNKS < KEYS_PER_SLOT, "too many chunks for a slot");
+
+static uint32_t header_key(int slot) {
+    return KEY_BASE + slot * KEYS_PER_SLOT;
+}
+
+static uint32_t chunk_key(int slot, int chunk) {
+    return header_key(slot) + 1 + chunk;
+}
+
+/**
+ * FNV-1a over the stored records, so a header is only trusted alongside the chunks it was written with.
+ */
+static uint32_t checksum(const StoredRecord *records, uint8_t num_records) {
+    const uint8_t *bytes = (const uint8_t *) records;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < num_records * sizeof(StoredRecord); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool read_header(int slot, StoreHeader *header) {
+    return persist_read_data(header_key(slot), header, sizeof(StoreHeader)) == (int) sizeof(StoreHeader)
+            && header->version == BG_STORE_VERSION
+            && header->num_records <= BG_STORE_MAX_RECORDS;
+}
+
+static bool read_records(int slot, const StoreHeader *header, StoredRecord *records) {
+    for (unsigned int chunk = 0; chunk * RECORDS_PER_CHUNK < header->num_records; chunk++) {
+        unsigned int count = header->num_records - chunk * RECORDS_PER_CHUNK;
+        if (count > RECORDS_PER_CHUNK) {
+            count = RECORDS_PER_CHUNK;
+        }
+        int size = count * sizeof(StoredRecord);
+        if (persist_read_data(chunk_key(slot, chunk), &records[chunk * RECORDS_PER_CHUNK], size) != size) {
+            return false;
+        }
+    }
+    return checksum(records, header->num_records) == header->checksum;
+}
+
+/**
+ * The slot holding the snapshot with the highest generation, or -1 if neither holds one.
+ */
+static int newest_slot() {
+    int slot = -1;
+    uint32_t generation = 0;
+    for (int s = 0; s < NUM_SLOTS; s++) {
+        StoreHeader header;
+        if (read_header(s, &header) && (slot < 0 || header.generation > generation)) {
+            slot = s;
+            generation = header.generation;
+        }
+    }
+    return slot;
+}
+
+void bg_store_save(const BgStoreState *state) {
+    StoredRecord records[BG_STORE_MAX_RECORDS];
+    StoreHeader header = {
+        .version = BG_STORE_VERSION,
+        .trend = state->trend,
+        .alert = state->alert,
+    };
+    strncpy(header.egv, state->egv, BG_STORE_EGV_LENGTH - 1);
+    strncpy(header.delta, state->delta, BG_STORE_DELTA_LENGTH - 1);
+
+    // snapshot the newest readings, oldest first
+    uint16_t count = bg_history_count();
+    uint16_t first = (count > BG_STORE_MAX_RECORDS) ? count - BG_STORE_MAX_RECORDS : 0;
+    const BgRecord *latest = bg_history_latest();
+    header.newest = latest ? latest->time : 0;
+    header.num_records = count - first;
+    for (uint16_t i = first; i < count; i++) {
+        const BgRecord *record = bg_history_at(i);
+        records[i - first] = (StoredRecord) {
+            .minutes = (header.newest - record->time) / 60,
+            .mgdl = record->mgdl
+        };
+    }
+    header.checksum = checksum(records, header.num_records);
+
+    // overwrite the slot that doesn't hold the newest snapshot
+    int slot = newest_slot();
+    header.generation = 1;
+    StoreHeader current;
+    if (slot >= 0 && read_header(slot, &current)) {
+        header.generation = current.generation + 1;
+    }
+    slot = (slot + 1) % NUM_SLOTS;
+
+    for (unsigned int chunk = 0; chunk * RECORDS_PER_CHUNK < header.num_records; chunk++) {
+        unsigned int remaining = header.num_records - chunk * RECORDS_PER_CHUNK;
+        unsigned int size = ((remaining > RECORDS_PER_CHUNK) ? RECORDS_PER_CHUNK : remaining) * sizeof(StoredRecord);
+        persist_write_data(chunk_key(slot, chunk), &records[chunk * RECORDS_PER_CHUNK], size);
+    }
+    persist_write_data(header_key(slot), &header, sizeof(header));
+}
+
+bool bg_store_load(BgStoreState *state) {
+    StoredRecord records[BG_STORE_MAX_RECORDS];
+    StoreHeader header;
+
+    // newest snapshot first, falling back to the other slot if its chunks don't check out
+    int newest = newest_slot();
+    if (newest < 0) {
+        return false;
+    }
+    int slot = -1;
+    for (int attempt = 0; attempt < NUM_SLOTS && slot < 0; attempt++) {
+        int candidate = (newest + attempt) % NUM_SLOTS;
+        if (read_header(candidate, &header) && read_records(candidate, &header, records)) {
+            slot = candidate;
+        }
+    }
+    if (slot < 0) {
+        return false;
+    }
+
+    bg_history_clear();
+    for (int i = 0; i < header.num_records; i++) {
+        bg_history_append(header.newest - records[i].minutes * 60, records[i].mgdl);
+    }
+
+    state->trend = header.trend;
+    state->alert = header.alert;
+    strncpy(state->egv, header.egv, BG_STORE_EGV_LENGTH);
+    state->egv[BG_STORE_EGV_LENGTH - 1] = '\0';
+    strncpy(state->delta, header.delta, BG_STORE_DELTA_LENGTH);
+    state->delta[BG_STORE_DELTA_LENGTH - 1] = '\0';
+    return true;
+}
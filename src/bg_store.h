@@ -0,0 +1,36 @@
+#pragma once
+
+#include <pebble.h>
+
+//! Persistent snapshot of the last known state, so the face can paint it
+//! from flash at launch instead of waiting on the phone.
+//!
+//! The snapshot is a header record plus chunks of history records. There are
+//! two copies (slots) of it on flash; a save always rewrites the slot that
+//! does not hold the newest snapshot, chunks first and header last. The header
+//! carries a generation counter and a checksum of the chunks, so a save that
+//! is interrupted part way leaves the other slot as the newest valid one.
+#define BG_STORE_VERSION 1
+#define BG_STORE_MAX_RECORDS 96
+#define BG_STORE_EGV_LENGTH 8
+#define BG_STORE_DELTA_LENGTH 24
+
+//! The scalar fields of the last reply from the phone.
+typedef struct {
+    uint8_t trend;
+    uint8_t alert;
+    char egv[BG_STORE_EGV_LENGTH];
+    char delta[BG_STORE_DELTA_LENGTH];
+} BgStoreState;
+
+//! Saves the state along with the newest BG_STORE_MAX_RECORDS readings of
+//! bg_history.
+//! @param state The scalar fields to save.
+void bg_store_save(const BgStoreState *state);
+
+//! Loads the newest valid snapshot, replacing the contents of bg_history
+//! with its readings.
+//! @param state Out: the scalar fields of the snapshot.
+//! @return true if a valid snapshot was found; `state` and bg_history are
+//! left untouched otherwise.
+bool bg_store_load(BgStoreState *state);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <pebble.h>
+
+//! Logging with compile-time levels and per-module switches.
+//!
+//! A call is compiled in only if its level is at or below CGM_LOG_LEVEL and
+//! its module's switch is on. Anything else is a constant false branch that
+//! the compiler drops, format string and arguments included, so disabled
+//! logging costs neither cycles nor radio time. The arguments are still type
+//! checked either way.
+//!
+//! Release builds (`--release`, see wscript) define RELEASE and only keep
+//! warnings and errors. Either default can be overridden with
+//! -DCGM_LOG_LEVEL=... or a module with -DCGM_LOG_<MODULE>=0.
+//!
+//! Usage: CGM_LOG_DEBUG(CHART, "range: %i", range);
+
+#define CGM_LOG_LEVEL_NONE 0
+#define CGM_LOG_LEVEL_ERROR 1
+#define CGM_LOG_LEVEL_WARNING 2
+#define CGM_LOG_LEVEL_INFO 3
+#define CGM_LOG_LEVEL_DEBUG 4
+
+#ifndef CGM_LOG_LEVEL
+#ifdef RELEASE
+#define CGM_LOG_LEVEL CGM_LOG_LEVEL_WARNING
+#else
+#define CGM_LOG_LEVEL CGM_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+//! App lifecycle and launch arguments.
+#ifndef CGM_LOG_APP
+#define CGM_LOG_APP 1
+#endif
+
+//! Alert and snooze evaluation, once per message from the phone.
+#ifndef CGM_LOG_ALERT
+#define CGM_LOG_ALERT 1
+#endif
+
+//! Fetch scheduling, a few times per reading.
+#ifndef CGM_LOG_FETCH
+#define CGM_LOG_FETCH 1
+#endif
+
+//! Chart layout and drawing, once per repaint.
+#ifndef CGM_LOG_CHART
+#define CGM_LOG_CHART 1
+#endif
+
+//! Reports from the performance instrumentation, see cgm_perf.h.
+#ifndef CGM_LOG_PERF
+#define CGM_LOG_PERF 1
+#endif
+
+#define CGM_LOG(module, level, app_log_level, fmt, ...) \
+    do { \
+        if (CGM_LOG_##module && CGM_LOG_LEVEL >= (level)) { \
+            APP_LOG(app_log_level, fmt, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define CGM_LOG_ERROR(module, fmt, ...) CGM_LOG(module, CGM_LOG_LEVEL_ERROR, APP_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define CGM_LOG_WARNING(module, fmt, ...) CGM_LOG(module, CGM_LOG_LEVEL_WARNING, APP_LOG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
+#define CGM_LOG_INFO(module, fmt, ...) CGM_LOG(module, CGM_LOG_LEVEL_INFO, APP_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define CGM_LOG_DEBUG(module, fmt, ...) CGM_LOG(module, CGM_LOG_LEVEL_DEBUG, APP_LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
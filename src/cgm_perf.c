@@ -0,0 +1,101 @@
+#include "cgm_perf.h"
+#include "cgm_log.h"
+
+#if CGM_PERF
+
+typedef struct {
+    int32_t samples[CGM_PERF_WINDOW];
+    uint16_t next;
+    uint16_t count;
+} PerfWindow;
+
+static PerfWindow s_windows[CGM_PERF_METRIC_COUNT];
+
+static const char *const METRIC_NAMES[CGM_PERF_METRIC_COUNT] = {
+    "update_proc ms",
+    "chart draw ms",
+    "chart layout ms",
+    "inbox ms",
+    "message bytes",
+    "heap used",
+    "heap free"
+};
+
+// Short names for the overlay, which only has room for a few characters per metric
+static const char *const METRIC_LABELS[CGM_PERF_METRIC_COUNT] = {
+    "upd", "drw", "lay", "in", "msg", "used", "free"
+};
+
+CgmPerfTimer cgm_perf_timer_begin(CgmPerfMetric metric) {
+    CgmPerfTimer timer = { .metric = metric };
+    time_ms(&timer.seconds, &timer.ms);
+    return timer;
+}
+
+void cgm_perf_timer_end(CgmPerfTimer *timer) {
+    time_t seconds;
+    uint16_t ms;
+    time_ms(&seconds, &ms);
+    cgm_perf_record(timer->metric, (int32_t) (seconds - timer->seconds) * 1000 + ms - timer->ms);
+}
+
+void cgm_perf_record(CgmPerfMetric metric, int32_t value) {
+    PerfWindow *window = &s_windows[metric];
+    window->samples[window->next] = value;
+    window->next = (window->next + 1) % CGM_PERF_WINDOW;
+    if (window->count < CGM_PERF_WINDOW) {
+        window->count++;
+    }
+}
+
+void cgm_perf_sample_heap(void) {
+    cgm_perf_record(CGM_PERF_HEAP_USED, heap_bytes_used());
+    cgm_perf_record(CGM_PERF_HEAP_FREE, heap_bytes_free());
+}
+
+void cgm_perf_get_stats(CgmPerfMetric metric, CgmPerfStats *stats) {
+    const PerfWindow *window = &s_windows[metric];
+    *stats = (CgmPerfStats) { .count = window->count };
+    if (!window->count) {
+        return;
+    }
+    int32_t sum = 0;
+    stats->min = stats->max = window->samples[0];
+    for (int i = 0; i < window->count; i++) {
+        int32_t sample = window->samples[i];
+        sum += sample;
+        if (sample < stats->min) {
+            stats->min = sample;
+        }
+        if (sample > stats->max) {
+            stats->max = sample;
+        }
+    }
+    stats->avg = sum / window->count;
+}
+
+void cgm_perf_format(char *buffer, size_t size) {
+    size_t length = 0;
+    buffer[0] = '\0';
+    for (int metric = 0; metric < CGM_PERF_METRIC_COUNT && length < size; metric++) {
+        CgmPerfStats stats;
+        cgm_perf_get_stats(metric, &stats);
+        int written = snprintf(buffer + length, size - length, "%s %ld/%ld/%ld%s", METRIC_LABELS[metric],
+                               stats.min, stats.avg, stats.max, (metric % 2) ? "\n" : "  ");
+        if (written < 0) {
+            break;
+        }
+        length += written;
+    }
+}
+
+void cgm_perf_log_report(void) {
+    for (int metric = 0; metric < CGM_PERF_METRIC_COUNT; metric++) {
+        CgmPerfStats stats;
+        cgm_perf_get_stats(metric, &stats);
+        CGM_LOG_INFO(PERF, "%s: min %ld avg %ld max %ld (%d samples)", METRIC_NAMES[metric],
+                     stats.min, stats.avg, stats.max, stats.count);
+    }
+}
+
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <pebble.h>
+
+//! Performance instrumentation: scoped timers around the draw and message
+//! paths, heap samples and AppMessage sizes, each kept as a rolling window
+//! of the last CGM_PERF_WINDOW samples.
+//!
+//! Compiled in unless CGM_PERF is 0, which it is by default in release
+//! builds; the macros below then expand to nothing.
+//!
+//! Usage, at the top of a function:
+//!     CGM_PERF_SCOPE(CGM_PERF_CHART_DRAW);
+//! times everything up to the function's return, whichever one it takes.
+#ifndef CGM_PERF
+#ifdef RELEASE
+#define CGM_PERF 0
+#else
+#define CGM_PERF 1
+#endif
+#endif
+
+#define CGM_PERF_WINDOW 16
+
+typedef enum {
+    CGM_PERF_UPDATE_PROC,       // ms in the canvas update_proc
+    CGM_PERF_CHART_DRAW,        // ms in chart_layer_update_func
+    CGM_PERF_CHART_LAYOUT,      // ms in chart_layer_update_layout
+    CGM_PERF_INBOX,             // ms in inbox_received_callback
+    CGM_PERF_MESSAGE_BYTES,     // size of each AppMessage received
+    CGM_PERF_HEAP_USED,         // heap_bytes_used() after each AppMessage
+    CGM_PERF_HEAP_FREE,         // heap_bytes_free() after each AppMessage
+    CGM_PERF_METRIC_COUNT
+} CgmPerfMetric;
+
+//! Rolling statistics of a metric over its window.
+typedef struct {
+    int32_t min;
+    int32_t avg;
+    int32_t max;
+    uint16_t count;             // samples in the window, up to CGM_PERF_WINDOW
+} CgmPerfStats;
+
+//! A running timer, see CGM_PERF_SCOPE.
+typedef struct {
+    CgmPerfMetric metric;
+    time_t seconds;
+    uint16_t ms;
+} CgmPerfTimer;
+
+#if CGM_PERF
+
+#define CGM_PERF_SCOPE(metric) \
+    CgmPerfTimer cgm_perf_timer __attribute__((cleanup(cgm_perf_timer_end))) = cgm_perf_timer_begin(metric)
+#define CGM_PERF_RECORD(metric, value) cgm_perf_record(metric, value)
+#define CGM_PERF_SAMPLE_HEAP() cgm_perf_sample_heap()
+
+//! Starts timing `metric`; use CGM_PERF_SCOPE rather than calling this.
+CgmPerfTimer cgm_perf_timer_begin(CgmPerfMetric metric);
+
+//! Records the time since `timer` began against its metric.
+void cgm_perf_timer_end(CgmPerfTimer *timer);
+
+//! Adds a sample to a metric's window, dropping its oldest sample once full.
+void cgm_perf_record(CgmPerfMetric metric, int32_t value);
+
+//! Records heap_bytes_used() and heap_bytes_free().
+void cgm_perf_sample_heap(void);
+
+//! @param metric The metric to get.
+//! @param stats Out: the min, average and max over the metric's window.
+void cgm_perf_get_stats(CgmPerfMetric metric, CgmPerfStats *stats);
+
+//! Writes a short summary of every metric, for the debug overlay.
+//! @param buffer The buffer to write to.
+//! @param size The size of `buffer`.
+void cgm_perf_format(char *buffer, size_t size);
+
+//! Sends every metric to the phone log, one line each.
+void cgm_perf_log_report(void);
+
+#else
+
+#define CGM_PERF_SCOPE(metric) do { } while (0)
+#define CGM_PERF_RECORD(metric, value) do { } while (0)
+#define CGM_PERF_SAMPLE_HEAP() do { } while (0)
+
+#endif
@@ -1,6 +1,6 @@
 /*
 
-Data Processor v1.1
+Data Processor v1.2
 A Pebble library for extracting elements from a delimited string.
 http://smallstoneapps.github.io/data-processor/
 
@@ -37,12 +37,6 @@ data-processor.c
 #include <pebble.h>
 #include "data-processor.h"
 
-struct ProcessingState {
-  char* data_start;
-  char* data_pos;
-  char data_delim;
-};
-
 static ProcessingState* global = NULL;
 
 void data_processor_init(char* data, char delim) {
@@ -52,10 +46,18 @@ void data_processor_init(char* data, char delim) {
 
 ProcessingState* data_processor_create(char* data, char delim) {
   ProcessingState* state = malloc(sizeof(ProcessingState));
+  data_processor_init_state(state, data, delim);
+  return state;
+}
+
+// Sets up a caller-owned state (e.g. on the stack), so parsing needs no heap at all.
+void data_processor_init_state(ProcessingState* state, char* data, char delim) {
+  if (NULL == state) {
+    return;
+  }
   state->data_start = data;
   state->data_pos = data;
   state->data_delim = delim;
-  return state;
 }
 
 void data_processor_destroy(ProcessingState* state) {
@@ -74,22 +76,19 @@ ProcessingState* data_processor_get_global(void) {
   return global;
 }
 
-uint8_t data_processor_count(ProcessingState* state) {
-  if (NULL == state) {
-    return 0;
-  }
-  if (strlen(state->data_start) == 0) {
+uint16_t data_processor_count(ProcessingState* state) {
+  if (NULL == state || *state->data_start == '\0') {
     return 0;
   }
-  char* pos = state->data_start;
-  uint8_t count = 0;
-  while (*pos != '\0') {
-    if (*pos == state->data_delim) {
+  // a trailing delimiter ends the last field rather than starting an empty
+  // one, the same as data_processor_parse_int_array sees it
+  uint16_t count = 1;
+  for (char* pos = state->data_start; *pos != '\0'; pos++) {
+    if (*pos == state->data_delim && *(pos + 1) != '\0') {
       count += 1;
     }
-    pos++;
   }
-  return ++count;
+  return count;
 }
 
 char* data_processor_get_string(ProcessingState* state) {
@@ -120,12 +119,42 @@ bool data_processor_get_bool(ProcessingState* state) {
   return (bool_char == '1');
 }
 
+// Parses the next field as an integer in place, in a single pass and without
+// copying it. Like atoi, leading spaces and a sign are accepted and parsing
+// stops at the first non-digit; the rest of the field is skipped.
 int data_processor_get_int(ProcessingState* state) {
   if (NULL == state) {
     return -1;
   }
-  char* tmp_str = data_processor_get_string(state);
-  int num = atoi(tmp_str);
-  free(tmp_str);
-  return num;
-}
\ No newline at end of file
+  char* pos = state->data_pos;
+  while (*pos == ' ') {
+    pos++;
+  }
+  bool negative = (*pos == '-');
+  if (*pos == '-' || *pos == '+') {
+    pos++;
+  }
+  int num = 0;
+  while (*pos >= '0' && *pos <= '9') {
+    num = (num * 10) + (*pos - '0');
+    pos++;
+  }
+  while (*pos != state->data_delim && *pos != '\0') {
+    pos++;
+  }
+  state->data_pos = (*pos == '\0') ? pos : pos + 1;
+  return negative ? -num : num;
+}
+
+// Parses up to `cap` integer fields into a caller-owned buffer.
+// Returns the number of values written.
+uint16_t data_processor_parse_int_array(ProcessingState* state, int* out, uint16_t cap) {
+  if (NULL == state || NULL == out) {
+    return 0;
+  }
+  uint16_t count = 0;
+  while (count < cap && *state->data_pos != '\0') {
+    out[count++] = data_processor_get_int(state);
+  }
+  return count;
+}
@@ -1,6 +1,6 @@
 /*
 
-Data Processor v1.1
+Data Processor v1.2
 A Pebble library for extracting elements from a delimited string.
 http://smallstoneapps.github.io/data-processor/
 
@@ -39,19 +39,28 @@ data-processor.h
 #include <pebble.h>
 
 #define DATA_PROCESSOR_VERSION_MAJOR 1
-#define DATA_PROCESSOR_VERSION_MINOR 1
+#define DATA_PROCESSOR_VERSION_MINOR 2
+
+// Defined here so a state can live on the stack; see data_processor_init_state.
+struct ProcessingState {
+  char* data_start;
+  char* data_pos;
+  char data_delim;
+};
 
 typedef struct ProcessingState ProcessingState;
 
 void data_processor_init(char* data, char delim);
 ProcessingState* data_processor_create(char* data, char delim);
+void data_processor_init_state(ProcessingState* state, char* data, char delim);
 
 void data_processor_destroy(ProcessingState* state);
 void data_processor_deinit();
 
 ProcessingState* data_processor_get_global(void);
 
-uint8_t data_processor_count(ProcessingState* state);
+uint16_t data_processor_count(ProcessingState* state);
 char* data_processor_get_string(ProcessingState* state);
 bool data_processor_get_bool(ProcessingState* state);
-int data_processor_get_int(ProcessingState* state);
\ No newline at end of file
+int data_processor_get_int(ProcessingState* state);
+uint16_t data_processor_parse_int_array(ProcessingState* state, int* out, uint16_t cap);
\ No newline at end of file
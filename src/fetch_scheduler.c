@@ -0,0 +1,115 @@
+#include "fetch_scheduler.h"
+#include "cgm_log.h"
+
+// Time for a reading to get from the sensor to wherever the phone fetches it from
+#define UPLOAD_GRACE 20
+// An overdue reading is looked for this often, this many times, before falling back to the sensor's cadence
+#define LATE_RETRY_INTERVAL 60
+#define MAX_LATE_RETRIES 2
+// A request without a reply after this long has failed
+#define REPLY_TIMEOUT 30
+// Backoff after a failure: BACKOFF_BASE doubling up to BACKOFF_MAX, spread by +/- 1/8 so retries don't line up
+#define BACKOFF_BASE 10
+#define BACKOFF_MAX FETCH_READING_INTERVAL
+
+static FetchSchedulerCallback s_callback = NULL;
+static AppTimer *s_fetch_timer = NULL;
+static AppTimer *s_timeout_timer = NULL;
+static uint8_t s_failures = 0;
+static uint8_t s_late_retries = 0;
+static bool s_push = false;
+
+static void cancel(AppTimer **timer) {
+    if (*timer) {
+        app_timer_cancel(*timer);
+        *timer = NULL;
+    }
+}
+
+static void timeout_callback(void *data) {
+    s_timeout_timer = NULL;
+    CGM_LOG_DEBUG(FETCH, "no reply");
+    // whatever pushed to us has gone; follow the sensor again until the phone says otherwise
+    s_push = false;
+    fetch_scheduler_on_failure();
+}
+
+static void fetch_callback(void *data) {
+    s_fetch_timer = NULL;
+    cancel(&s_timeout_timer);
+    s_timeout_timer = app_timer_register(REPLY_TIMEOUT * 1000, timeout_callback, NULL);
+    if (s_callback) {
+        s_callback();
+    }
+}
+
+void fetch_scheduler_init(FetchSchedulerCallback callback) {
+    s_callback = callback;
+    s_failures = 0;
+    s_late_retries = 0;
+    srand(time(NULL));
+}
+
+void fetch_scheduler_deinit(void) {
+    cancel(&s_fetch_timer);
+    cancel(&s_timeout_timer);
+    s_callback = NULL;
+}
+
+void fetch_scheduler_fetch_soon(uint32_t seconds) {
+    cancel(&s_fetch_timer);
+    CGM_LOG_DEBUG(FETCH, "next fetch in %d s", (int) seconds);
+    s_fetch_timer = app_timer_register(seconds * 1000, fetch_callback, NULL);
+}
+
+void fetch_scheduler_on_reply(uint32_t newest) {
+    cancel(&s_timeout_timer);
+    s_failures = 0;
+
+    if (s_push) {
+        // every message from the phone shows the link is alive, so the heartbeat only goes out after a silence
+        fetch_scheduler_fetch_soon(FETCH_HEARTBEAT_INTERVAL);
+        return;
+    }
+
+    uint32_t now = time(NULL);
+    if (!newest) {
+        fetch_scheduler_fetch_soon(FETCH_READING_INTERVAL);
+        return;
+    }
+
+    uint32_t due = newest + FETCH_READING_INTERVAL + UPLOAD_GRACE;
+    if (due > now) {
+        s_late_retries = 0;
+        fetch_scheduler_fetch_soon(due - now);
+    } else if (s_late_retries < MAX_LATE_RETRIES) {
+        s_late_retries++;
+        fetch_scheduler_fetch_soon(LATE_RETRY_INTERVAL);
+    } else {
+        // the sensor has skipped readings; look again when the next one in its cadence is due
+        uint32_t missed = (now - newest) / FETCH_READING_INTERVAL;
+        fetch_scheduler_fetch_soon(newest + (missed + 1) * FETCH_READING_INTERVAL + UPLOAD_GRACE - now);
+    }
+}
+
+void fetch_scheduler_on_failure(void) {
+    cancel(&s_timeout_timer);
+    if (s_failures < UINT8_MAX) {
+        s_failures++;
+    }
+
+    uint32_t backoff = BACKOFF_MAX;
+    if (s_failures <= 8 && (BACKOFF_BASE << (s_failures - 1)) < BACKOFF_MAX) {
+        backoff = BACKOFF_BASE << (s_failures - 1);
+    }
+    int32_t jitter = (int32_t) (rand() % (backoff / 4 + 1)) - (int32_t) (backoff / 8);
+    fetch_scheduler_fetch_soon(backoff + jitter);
+}
+
+void fetch_scheduler_set_push(bool push) {
+    s_push = push;
+}
+
+uint8_t fetch_scheduler_failures(void) {
+    return s_failures;
+}
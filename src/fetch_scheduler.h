@@ -0,0 +1,57 @@
+#pragma once
+
+#include <pebble.h>
+
+//! Decides when the watch asks the phone for data.
+//!
+//! A CGM takes a reading every 5 minutes, counted from the timestamp of the
+//! previous one, so after each reply the next fetch is planned for shortly
+//! after the next reading is due rather than on minute ticks. A reading that
+//! is overdue is looked for a couple more times at short intervals, then once
+//! per expected reading after that. Failed fetches, including requests the
+//! phone never answers, are retried with exponential backoff and jitter.
+//!
+//! When the phone says it pushes readings by itself, the watch stops
+//! following the sensor and only sends a heartbeat request when the phone
+//! has been silent for FETCH_HEARTBEAT_INTERVAL, to notice a dead link.
+
+//! Called whenever a fetch is due; it should send the request to the phone.
+typedef void (*FetchSchedulerCallback)(void);
+
+//! Seconds between two CGM readings.
+#define FETCH_READING_INTERVAL 300
+
+//! Seconds of silence from a pushing phone before the watch asks for data.
+#define FETCH_HEARTBEAT_INTERVAL (3 * FETCH_READING_INTERVAL)
+
+//! Starts the scheduler. Nothing is fetched until fetch_scheduler_fetch_soon
+//! or one of the reply handlers plans the first fetch.
+//! @param callback The function that sends a request.
+void fetch_scheduler_init(FetchSchedulerCallback callback);
+
+//! Cancels any planned fetch.
+void fetch_scheduler_deinit(void);
+
+//! Plans a fetch in `seconds`, replacing any fetch already planned.
+//! @param seconds The delay before fetching.
+void fetch_scheduler_fetch_soon(uint32_t seconds);
+
+//! To be called for every reply from the phone. Clears the failure count and
+//! plans the next fetch after the next reading is due.
+//! @param newest The time of the newest reading held, seconds since the
+//! epoch, or 0 if none is held.
+void fetch_scheduler_on_reply(uint32_t newest);
+
+//! To be called when a request or its reply is lost. Plans a retry after a
+//! backoff that doubles with every consecutive failure.
+void fetch_scheduler_on_failure(void);
+
+//! Switches between following the sensor's cadence and only sending
+//! heartbeats. Takes effect from the next reply. To be called for every
+//! reply, as push mode is dropped as soon as one does not say it; a request
+//! that goes unanswered drops it too.
+//! @param push true if the phone pushes new readings by itself.
+void fetch_scheduler_set_push(bool push);
+
+//! @return The number of consecutive failed fetches.
+uint8_t fetch_scheduler_failures(void);
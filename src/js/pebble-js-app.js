@@ -2,8 +2,205 @@ var fix = 0;
 var hasTimeline = 1;
 var topic = "not_set";
 var defaultId = 99;
+var BG_PACKET_VERSION = 2;
+var BG_PACKET_FLAG_FULL = 0x01;
+
+// How many readings (one every 5 minutes) to send the watch on a full resync.
+var historyDepth = 36;
+
+// What the watch told us on the last request: the id of the reading it shows
+// (defaultId when it shows none), the time (in seconds) of the newest reading it
+// holds and its packet version.
+var watchSync = { 'id': defaultId, 'since': 0, 'version': 0 };
+
+// Sent instead of a full reply when the watch already shows the newest reading.
+var ALERT_NO_CHANGE = 3;
+// From this age on the watch face shows the reading as old, which needs a full reply.
+var OLD_READING_MINUTES = 15;
+
+// Push mode: the phone fetches by itself, shortly after each reading is due, and
+// only sends the watch readings it has not seen yet. The watch then just sends a
+// heartbeat request now and then to check the phone is still there.
+var READING_INTERVAL = 5 * 60 * 1000;
+var UPLOAD_GRACE = 20 * 1000;
+var LATE_RETRY_INTERVAL = 60 * 1000;
+var MAX_LATE_RETRIES = 2;
+var BACKOFF_BASE = 10 * 1000;
+// A failed fetch the watch did not ask for is only reported to it once this many
+// have failed in a row, so an outage does not buzz the watch on every retry.
+var REPORT_FAILURES = 3;
+var push = { 'timer': null, 'lateRetries': 0, 'failures': 0, 'sentId': null, 'sentState': null };
+
+// Whether the watch is waiting on a reply, which it gets even if nothing changed.
+var watchRequested = true;
+
+// Only one fetch runs at a time. A request made while it runs joins it and gets
+// its reply. Responses to a fetch that was superseded (by new settings) or that
+// never finished within FLIGHT_TIMEOUT are dropped when they turn up.
+var FLIGHT_TIMEOUT = 60 * 1000;
+var flight = { 'id': 0, 'active': false, 'started': 0 };
+
+// Starts a fetch and returns its id, or 0 if it should join the one running.
+function startFlight(supersede) {
+    var now = Date.now();
+    if (flight.active && !supersede && now - flight.started < FLIGHT_TIMEOUT) {
+        return 0;
+    }
+    flight.id++;
+    flight.active = true;
+    flight.started = now;
+    return flight.id;
+}
+
+function endFlight() {
+    flight.active = false;
+}
+
+// Whether the fetch `options` belongs to has been replaced by a newer one.
+function superseded(options) {
+    if (options.flight == flight.id) {
+        return false;
+    }
+    console.log("dropping response of superseded fetch " + options.flight);
+    return true;
+}
+
+function schedulePush(delay) {
+    if (push.timer) {
+        clearTimeout(push.timer);
+    }
+    push.timer = setTimeout(function () {
+        push.timer = null;
+        fetchCgmData(push.sentId);
+    }, delay);
+}
+
+// Plans the next fetch for just after the reading following `newest` (ms) is due.
+// An overdue reading is looked for a couple more times, then once per reading.
+function pushSucceeded(newest) {
+    push.failures = 0;
+    var now = Date.now();
+    var due = newest + READING_INTERVAL + UPLOAD_GRACE;
+    if (due > now) {
+        push.lateRetries = 0;
+        schedulePush(due - now);
+    } else if (push.lateRetries < MAX_LATE_RETRIES) {
+        push.lateRetries++;
+        schedulePush(LATE_RETRY_INTERVAL);
+    } else {
+        var missed = Math.floor((now - newest) / READING_INTERVAL);
+        schedulePush(newest + (missed + 1) * READING_INTERVAL + UPLOAD_GRACE - now);
+    }
+}
 
-function fetchCgmData(id) {
+// Retries a failed fetch after a backoff that doubles up to a reading interval.
+// Returns whether to send the watch the error.
+function pushFailed() {
+    endFlight();
+    var report = watchRequested || push.failures + 1 == REPORT_FAILURES;
+    watchRequested = false;
+    push.failures++;
+    var backoff = Math.min(BACKOFF_BASE * Math.pow(2, push.failures - 1), READING_INTERVAL);
+    schedulePush(backoff + (Math.random() - 0.5) * backoff / 4);
+    if (report) {
+        watchSync.id = defaultId;
+    }
+    return report;
+}
+
+// What the watch shows of a reading besides its age: which one it is, its alert
+// and whether it is old. A reading going old changes the last two.
+function shownState(message) {
+    return message.id + ':' + message.alert + ':' + (message.time_delta_int >= OLD_READING_MINUTES);
+}
+
+// Sends a reading to the watch, along with the readings (newest first) it does
+// not hold yet, unless the phone fetched it by itself and the watch already
+// shows it. Returns whether it was sent.
+function sendReading(message, newest, readings, source) {
+    endFlight();
+    pushSucceeded(newest);
+    saveLastReading(source, message, newest, readings);
+    if (!watchRequested && shownState(message) == push.sentState) {
+        return false;
+    }
+    deliverReading(message, readings);
+    return true;
+}
+
+// Sends the reading, or if the watch shows it already, just its age. What the
+// watch holds only moves on once it acknowledges the reading; if it does not, it
+// is sent again, with the full history, after a backoff.
+function deliverReading(message, readings) {
+    if (sameId(message.id, watchSync.id) && message.time_delta_int < OLD_READING_MINUTES) {
+        Pebble.sendAppMessage({
+            "id": message.id,
+            "alert": ALERT_NO_CHANGE,
+            "time_delta_int": message.time_delta_int,
+            "push": 1
+        });
+    } else {
+        var packet = createBgPacket(readings);
+        message.bgs = packet.bytes;
+        message.push = 1;
+        Pebble.sendAppMessage(message, function () {
+            if (packet.newest) {
+                watchSync.since = packet.newest;
+                watchSync.version = BG_PACKET_VERSION;
+            }
+            watchSync.id = message.id;
+        }, function () {
+            watchSync.since = 0;
+            watchSync.id = defaultId;
+            push.sentId = null;
+            push.sentState = null;
+            schedulePush(BACKOFF_BASE);
+        });
+    }
+    push.sentId = message.id;
+    push.sentState = shownState(message);
+    watchRequested = false;
+}
+
+// The last reading sent, with the readings behind it, kept so that a request from
+// the watch is answered straight away while the phone fetches in the background.
+// The fetch then only sends the watch something if it found a newer reading.
+var LAST_READING_KEY = 'cgmLastReading';
+// Past this age the watch face shows the reading as old, so it waits for the fetch.
+var LAST_READING_MAX_AGE = OLD_READING_MINUTES * 60 * 1000;
+
+function readingSource(options) {
+    return options.mode + ':' + (options.mode == 'Share' ? options.accountName : options.api);
+}
+
+function saveLastReading(source, message, newest, readings) {
+    window.localStorage.setItem(LAST_READING_KEY, JSON.stringify({
+        'source': source,
+        'message': message,
+        'newest': newest,
+        'readings': readings
+    }));
+}
+
+// Answers the watch from the last reading, with its age brought up to date and
+// without vibrating again. Returns whether there was one recent enough.
+function sendLastReading(source) {
+    var last = JSON.parse(window.localStorage.getItem(LAST_READING_KEY) || 'null');
+    var age = last ? Date.now() - last.newest : 0;
+    if (!last || last.source != source || age < 0 || age >= LAST_READING_MAX_AGE) {
+        return false;
+    }
+    var message = last.message;
+    message.time_delta_int = Math.floor(age / 60000);
+    message.vibe = 0;
+    deliverReading(message, last.readings);
+    return true;
+}
+
+// Fetches the latest readings for the watch; `supersede` abandons a fetch still
+// running instead of joining it. A watch waiting on a reply gets the last reading
+// first, unless the settings just changed.
+function fetchCgmData(id, supersede) {
    var options = JSON.parse(window.localStorage.getItem('cgmPebbleDuo')) || 
      {   'mode': 'Default' ,
             'high': 180,
@@ -15,6 +212,17 @@ function fetchCgmData(id) {
             'vibe' : 1,
             'raw' : false,
         };
+    options.source = readingSource(options);
+    if (watchRequested && !supersede && sendLastReading(options.source)) {
+        console.log("answered from the last reading, revalidating");
+    }
+
+    var flightId = startFlight(supersede);
+    if (!flightId) {
+        console.log("joining fetch " + flight.id);
+        return;
+    }
+    options.flight = flightId;
     console.log("region: " + options.region);
     switch (options.mode) {
         case "Rogue":
@@ -46,6 +254,7 @@ function fetchCgmData(id) {
             break;
             
          default:
+         endFlight();
          Pebble.sendAppMessage({
                     "vibe": 1, 	
                     "egv": "set",		
@@ -102,6 +311,9 @@ function noiseIntToNoiseString (noiseInt) {
 
 //ERRORS GETTING DATA
 function sendAuthError() {
+    if (!pushFailed()) {
+        return;
+    }
     Pebble.sendAppMessage({
                     "vibe": 1, 	
                     "egv": "log",		
@@ -114,6 +326,9 @@ function sendAuthError() {
 }
 
 function sendTimeOutError() {
+    if (!pushFailed()) {
+        return;
+    }
      Pebble.sendAppMessage({
             "vibe": parseInt(options.vibe_temp,10),
             "egv": "tot",
@@ -126,6 +341,9 @@ function sendTimeOutError() {
 }
 
 function sendServerError() {
+    if (!pushFailed()) {
+        return;
+    }
     Pebble.sendAppMessage({
             "vibe": parseInt(options.vibe_temp,10),
             "egv": "svr",
@@ -138,6 +356,9 @@ function sendServerError() {
 }
 
 function sendUnknownError(msg) {
+    if (!pushFailed()) {
+        return;
+    }
     Pebble.sendAppMessage({
                 "delta": msg,
                 "egv": "exc",
@@ -155,6 +376,9 @@ function getNightscoutCalRecord(options){
     var http = new XMLHttpRequest();
     http.open("GET", url, true);
     http.onload = function (e) {
+        if (superseded(options)) {
+            return;
+        }
              
         if (http.status == 200) {
             var data = JSON.parse(http.responseText);
@@ -177,9 +401,15 @@ function getNightscoutCalRecord(options){
     };
     
     http.onerror = function () {        
+        if (superseded(options)) {
+            return;
+        }
         sendServerError();
     };
     http.ontimeout = function () {
+        if (superseded(options)) {
+            return;
+        }
         sendTimeOutError();
     };
 
@@ -212,13 +442,20 @@ function nightscout(options) {
     var now = new Date();
     var http = new XMLHttpRequest();
 
-    var url = options.api + "/api/v1/entries/sgv.json?count=9";
+    var cached = loadReadingCache(options.api);
+    var url = options.api + "/api/v1/entries/sgv.json?count=" + historyDepth;
+    if (cached.length > 0) {
+        url += "&find[date][$gt]=" + cached[0].date;
+    }
     http.open("GET", url, true);
 
     http.onload = function (e) {
+        if (superseded(options)) {
+            return;
+        }
              
         if (http.status == 200) {
-            var data = JSON.parse(http.responseText);
+            var data = mergeReadingCache(options.api, cached, JSON.parse(http.responseText));
             //console.log("response: " + http.responseText);        
             if (data.length === 0) {               
                 sendUnknownError("data err");
@@ -377,21 +614,19 @@ function nightscout(options) {
                 
                 
                 
-                Pebble.sendAppMessage({
+                var sent = sendReading({
                     "delta": delta + deltaSuffix,
                     "egv": egv,	
                     "trend": trend,	
                     "alert": alert,	
                     "vibe": options.vibe_temp,
                     "id": data[0].date,
-                    "time_delta_int": timeDeltaMinutes,
-                    "bgs" : createNightscoutBgArray(data),
-                    "bg_times" : createNightscoutBgTimeArray(data)
-                });
+                    "time_delta_int": timeDeltaMinutes
+                }, data[0].date, createNightscoutReadings(data), options.source);
                 options.id = data[0].date;
                 window.localStorage.setItem('cgmPebbleDuo', JSON.stringify(options));
 
-                if (hasTimeline) {
+                if (sent && hasTimeline) {
                     insertUserPin(pin, topic, function (responseText) {
                         console.log('Result: ' + responseText);
                     });
@@ -405,9 +640,15 @@ function nightscout(options) {
     };
     
     http.onerror = function () {        
+        if (superseded(options)) {
+            return;
+        }
         sendServerError();
     };
     http.ontimeout = function () {
+        if (superseded(options)) {
+            return;
+        }
         sendTimeOutError();
     };
 
@@ -420,33 +661,85 @@ function nightscout(options) {
     
 }
 
-function createNightscoutBgArray(data) {
-    var toReturn = "0,"; 
-    var now = new Date();  
-    for (var i = 0; i < data.length; i++) {       
+// Nightscout entries already fetched, newest first, are kept in localStorage along
+// with the site they came from, so each fetch only asks for newer entries.
+var READING_CACHE_KEY = 'cgmReadings';
+
+function loadReadingCache(source) {
+    var cache = JSON.parse(window.localStorage.getItem(READING_CACHE_KEY) || 'null');
+    return (cache && cache.source == source) ? cache.entries : [];
+}
+
+// Merges freshly fetched entries into the cached ones, keeping one entry per date
+// and the newest historyDepth of them, and saves the result. Returns the merged
+// entries, newest first; the saved copy is unaffected by changes made to them.
+function mergeReadingCache(source, cached, fresh) {
+    var seen = {};
+    var merged = [];
+    fresh.concat(cached).forEach(function (entry) {
+        if (!seen[entry.date]) {
+            seen[entry.date] = true;
+            merged.push(entry);
+        }
+    });
+    merged.sort(function (a, b) {
+        return b.date - a.date;
+    });
+    merged = merged.slice(0, historyDepth);
+    window.localStorage.setItem(READING_CACHE_KEY, JSON.stringify({ 'source': source, 'entries': merged }));
+    return merged;
+}
+
+function createNightscoutReadings(data) {
+    var readings = [];
+    var now = new Date();
+    for (var i = 0; i < data.length; i++) {
         var wall = parseInt(data[i].date);
         var timeAgo = msToMinutes(now.getTime() - wall);
-        if (timeAgo < 45 && data[i].type == 'sgv' && data[i].sgv >= 39) {  
-            toReturn = toReturn + data[i].sgv.toString() + ",";
+        if (timeAgo < historyDepth * 5 && data[i].type == 'sgv' && data[i].sgv >= 39) {
+            readings.push({ 'date': wall, 'sgv': parseInt(data[i].sgv, 10) });
         }
     }
-    toReturn = toReturn.replace(/,\s*$/, "");  
-    return toReturn;
+    return readings;
 }
-    
 
-function createNightscoutBgTimeArray(data) {
-    var toReturn = ""
-    var now = new Date();   
-    for (var i = 0; i < data.length; i++) {  
-        var wall = parseInt(data[i].date);
-        var timeAgo = msToMinutes(now.getTime() - wall);
-        if (timeAgo < 45 && data[i].type == 'sgv' && data[i].sgv >= 39) {
-            toReturn = toReturn + (45-timeAgo).toString() + ",";
+// Packs readings (newest first) into the binary history format read by bg_packet.c:
+// 8 byte header (version, count, flags, reserved, uint32 newest time in seconds)
+// followed by one (uint16 minutes before newest, int16 mg/dL) record per reading.
+// All fields are little-endian.
+//
+// Only the readings newer than what the watch already holds are sent. The full
+// window is sent instead when the watch holds nothing, speaks another packet
+// version, or every reading is newer than its newest one (there may be a gap).
+// An empty packet is never full: it would clear the history the watch holds.
+// Returns the bytes and the newest time packed (0 if none), which deliverReading
+// records as what the watch holds once it acknowledges the packet.
+function createBgPacket(readings) {
+    var fresh = [];
+    for (var i = 0; i < readings.length; i++) {
+        if (Math.floor(readings[i].date / 1000) > watchSync.since) {
+            fresh.push(readings[i]);
         }
-    } 
-    toReturn = toReturn.replace(/,\s*$/, "");  
-    return toReturn;  
+    }
+
+    var full = readings.length > 0 && (!watchSync.since || watchSync.version != BG_PACKET_VERSION
+        || fresh.length == readings.length);
+    if (full) {
+        fresh = readings;
+    }
+
+    var count = Math.min(fresh.length, 255);
+    var newest = (count > 0) ? Math.floor(fresh[0].date / 1000) : 0;
+    var bytes = [BG_PACKET_VERSION, count, full ? BG_PACKET_FLAG_FULL : 0, 0,
+        newest & 0xFF, (newest >>> 8) & 0xFF, (newest >>> 16) & 0xFF, (newest >>> 24) & 0xFF];
+
+    for (i = 0; i < count; i++) {
+        var minutes = Math.round((newest - fresh[i].date / 1000) / 60);
+        var sgv = fresh[i].sgv;
+        bytes.push(minutes & 0xFF, (minutes >> 8) & 0xFF, sgv & 0xFF, (sgv >> 8) & 0xFF);
+    }
+
+    return { 'bytes': bytes, 'newest': newest };
 }
 
 //use D's share API------------------------------------------//
@@ -480,7 +773,39 @@ function share(options) {
         , LatestGlucose: "https://"+ host + ".dexcom.com/ShareWebServices/Services/Publisher/ReadPublisherLatestGlucoseValues"
     };
 
-    authenticateShare(options, defaults);
+    var sessionId = loadShareSession(options, defaults);
+    if (sessionId) {
+        getShareGlucoseData(sessionId, defaults, options, true);
+    } else {
+        authenticateShare(options, defaults);
+    }
+}
+
+// The Share session is reused across fetches until it is SHARE_SESSION_MAX_AGE old
+// or Dexcom rejects it, rather than logging in again before every fetch.
+var SHARE_SESSION_KEY = 'shareSession';
+var SHARE_SESSION_MAX_AGE = 6 * 60 * 60 * 1000;
+
+function loadShareSession(options, defaults) {
+    var session = JSON.parse(window.localStorage.getItem(SHARE_SESSION_KEY) || 'null');
+    if (!session || session.accountName != options.accountName || session.login != defaults.login
+            || Date.now() - session.created > SHARE_SESSION_MAX_AGE) {
+        return null;
+    }
+    return session.id;
+}
+
+function saveShareSession(sessionId, options, defaults) {
+    window.localStorage.setItem(SHARE_SESSION_KEY, JSON.stringify({
+        'id': sessionId,
+        'accountName': options.accountName,
+        'login': defaults.login,
+        'created': Date.now()
+    }));
+}
+
+function clearShareSession() {
+    window.localStorage.removeItem(SHARE_SESSION_KEY);
 }
 
 function authenticateShare(options, defaults) {   
@@ -500,18 +825,29 @@ function authenticateShare(options, defaults) {
     
     var data;
     http.onload = function (e) {
+        if (superseded(options)) {
+            return;
+        }
         if (http.status == 200) {
-            data = getShareGlucoseData(http.responseText.replace(/['"]+/g, ''), defaults, options);
+            var sessionId = http.responseText.replace(/['"]+/g, '');
+            saveShareSession(sessionId, options, defaults);
+            data = getShareGlucoseData(sessionId, defaults, options, false);
         } else {
                 sendAuthError();           
         }
     };
     
        http.ontimeout = function () {
+        if (superseded(options)) {
+            return;
+        }
         sendTimeOutError();
     };
     
     http.onerror = function () {
+        if (superseded(options)) {
+            return;
+        }
         sendServerError();
     };
 
@@ -519,10 +855,12 @@ function authenticateShare(options, defaults) {
 
 }
 
-function getShareGlucoseData(sessionId, defaults, options) {
+// Fetches the readings with an existing session. A session Dexcom no longer accepts
+// is dropped, and if `retry` is set, logged in again once.
+function getShareGlucoseData(sessionId, defaults, options, retry) {
     var now = new Date();
     var http = new XMLHttpRequest();
-    var url = defaults.LatestGlucose + '?sessionID=' + sessionId + '&minutes=' + 1440 + '&maxCount=' + 8;
+    var url = defaults.LatestGlucose + '?sessionID=' + sessionId + '&minutes=' + 1440 + '&maxCount=' + historyDepth;
     http.open("POST", url, true);
 
     //Send the proper header information along with the request
@@ -532,6 +870,9 @@ function getShareGlucoseData(sessionId, defaults, options) {
     http.setRequestHeader('Content-Length', 0);
 
     http.onload = function (e) {
+        if (superseded(options)) {
+            return;
+        }
              
         if (http.status == 200) {
             var data = JSON.parse(http.responseText);
@@ -637,21 +978,19 @@ function getShareGlucoseData(sessionId, defaults, options) {
                     if (timeDeltaMinutes % 5 === 0)
                         alert = 4;
                 }
-                Pebble.sendAppMessage({
+                var sent = sendReading({
                     "delta": delta,
                     "egv": egv,	
                     "trend": trend,	
                     "alert": alert,	
                     "vibe": options.vibe_temp,
                     "id": wall,
-                    "time_delta_int": timeDeltaMinutes,
-                    "bgs" : createShareBgArray(data),
-                    "bg_times" : createShareBgTimeArray(data)
-                });
+                    "time_delta_int": timeDeltaMinutes
+                }, wall, createShareReadings(data), options.source);
                 options.id = wall;
                 window.localStorage.setItem('cgmPebbleDuo', JSON.stringify(options));
                 
-                if (hasTimeline) {
+                if (sent && hasTimeline) {
                     insertUserPin(pin, topic, function (responseText) {
                         console.log('Result: ' + responseText);
                     });
@@ -659,57 +998,57 @@ function getShareGlucoseData(sessionId, defaults, options) {
             }
 
         } else {
+            if (http.status == 500 || /Session/i.test(http.responseText)) {
+                clearShareSession();
+                if (retry) {
+                    authenticateShare(options, defaults);
+                    return;
+                }
+            }
             sendUnknownError("data err");
         }
     };
     
     http.onerror = function () { 
+        if (superseded(options)) {
+            return;
+        }
         sendServerError();
     };
    http.ontimeout = function () {
+        if (superseded(options)) {
+            return;
+        }
         sendTimeOutError();
     };
 
     http.send();
 }
 
-function createShareBgArray(data) {
-    var toReturn = "0,";
+function createShareReadings(data) {
+    var readings = [];
     var regex = /\((.*)\)/;
     var now = new Date();
     
     for (var i = 0; i < data.length; i++) {
         var wall = parseInt(data[i].WT.match(regex)[1]);
         var timeAgo = msToMinutes(now.getTime() - wall);
-        if (timeAgo < 45) {  
-            toReturn = toReturn + data[i].Value.toString() + ",";
+        if (timeAgo < historyDepth * 5) {  
+            readings.push({ 'date': wall, 'sgv': parseInt(data[i].Value, 10) });
         }
     }
-    toReturn = toReturn.replace(/,\s*$/, "");  
-    return toReturn;
-}
-    
-
-function createShareBgTimeArray(data) {
-    var toReturn = "";
-    var regex = /\((.*)\)/;
-    var now = new Date();
-    
-    for (var i = 0; i < data.length; i++) {  
-        var wall = parseInt(data[i].WT.match(regex)[1]);
-        var timeAgo = msToMinutes(now.getTime() - wall);
-        if (timeAgo < 45) {
-            toReturn = toReturn + (45-timeAgo).toString() + ",";
-        }
-    } 
-    toReturn = toReturn.replace(/,\s*$/, "");  
-    return toReturn;  
+    return readings;
 }
 
 function msToMinutes(millisec) {
     return (millisec / (1000 * 60)).toFixed(1);
 }
 
+// Reading ids are times in ms, which the watch only holds as a 32 bit int.
+function sameId(id, watchId) {
+    return watchId !== undefined && (id | 0) == (watchId | 0);
+}
+
 function calculateShareAlert(egv, currentId, options) {
     if (parseInt(options.id, 10) == parseInt(currentId, 10)) {
         options.vibe_temp = 0;
@@ -730,7 +1069,10 @@ function calculateShareAlert(egv, currentId, options) {
 
 //using something different? code it up here-------ROGUE-----------------------------//:
 function rogue(options) {
-   
+    // Nothing fetches yet, so end the flight fetchCgmData started, or every watch
+    // request would join it until FLIGHT_TIMEOUT. A fetcher coded here ends it
+    // instead through sendReading or one of the send*Error functions.
+    endFlight();
 }
 
 
@@ -742,7 +1084,10 @@ Pebble.addEventListener("showConfiguration", function () {
 Pebble.addEventListener("webviewclosed", function (e) {
     var options = JSON.parse(decodeURIComponent(e.response));
     window.localStorage.setItem('cgmPebbleDuo', JSON.stringify(options));
-    fetchCgmData(defaultId);
+    clearShareSession();
+    watchSync.id = defaultId;
+    watchRequested = true;
+    fetchCgmData(defaultId, true);
 });
 
 Pebble.addEventListener("ready",
@@ -758,11 +1103,18 @@ Pebble.addEventListener("ready",
             'vibe' : 1,
             'id' : defaultId,
         };     
+        watchRequested = true;
         fetchCgmData(options.id);
     });
 
 Pebble.addEventListener("appmessage",
     function (e) {
+        watchSync = {
+            'id': e.payload.id,
+            'since': parseInt(e.payload.since, 10) || 0,
+            'version': parseInt(e.payload.sync_version, 10) || 0
+        };
+        watchRequested = true;
         fetchCgmData(e.payload.id);
     });
     
@@ -6,46 +6,79 @@
 
 #include <pebble.h>
 #include <pebble_chart.h>
-#include <data-processor.h>
 #include <cgm_info.h>
+#include <bg_packet.h>
+#include <bg_history.h>
+#include <bg_chart.h>
+#include <bg_store.h>
+#include <bg_glyphs.h>
 #include <pebble_utils.h>
+#include <cgm_log.h>
+#include <cgm_perf.h>
+#include <fetch_scheduler.h>
 
 #define ANTIALIASING true
 #define SNOOZE_KEY 1
 #define LAYOUT_COSTIK 0
 
+/**
+ * The trend icons are kept in a single resource, in order of the trend values sent by the phone and followed by the
+ * refresh icon. Colour platforms load them as the frames of a draw command sequence built by tools/trend-pdc.js and
+ * paint them in the ink set by set_icon_ink(); aplite has no draw commands, so it keeps the rows of the png atlas
+ * built by tools/trend-atlas.js.
+ */
+#if defined(PBL_PLATFORM_BASALT) || defined(PBL_PLATFORM_CHALK)
+#define TREND_ICONS_PDC 1
+#else
+#define TREND_ICONS_PDC 0
+#endif
+#define TREND_ICON_SIZE 30
+#define TREND_ICON_COUNT 8          // NONE, UPUP, UP, UP45, FLAT, DOWN45, DOWN, DOWNDOWN
+#define TREND_ICON_REFRESH TREND_ICON_COUNT
+
 typedef struct {
     int hours;
     int minutes;
 } Time;
 
 static Window * s_main_window;
-static Layer * s_canvas_layer;
-
-static AppTimer *timer, *timer2;
+static Layer * s_canvas_layer, *s_alert_layer, *s_clock_band_layer;
 
 static GPoint s_center;
 static Time s_last_time;
-static int s_radius = 0, t_delta = 0, has_launched = 0, vibe_state = 1, alert_state = 0, check_count = 0, alert_snooze = 0;
-static int * bgs;
-static int * bg_times;
-static int num_bgs = 0;
-static int retry_interval = 5;
+static int s_radius = 0, t_delta = 0, has_launched = 0, vibe_state = 1, alert_state = 0, alert_snooze = 0;
 static int tag_raw = 0;
-static int is_web = 0;
-
-static GBitmap *icon_bitmap = NULL;
 
+#if TREND_ICONS_PDC
+static GDrawCommandSequence *trend_glyphs = NULL;
+static int icon_index = 0;
+static GColor icon_ink;
+static Layer * icon_layer;
+#else
+static GBitmap *trend_atlas = NULL;
+static GBitmap *trend_icons[TREND_ICON_COUNT + 1];
 static BitmapLayer * icon_layer;
-static TextLayer * bg_layer, *delta_layer, *time_delta_layer, *time_layer;
+#endif
+static TextLayer * delta_layer, *time_delta_layer, *time_layer;
+static Layer * bg_layer;
+static const char *bg_text = NULL;
+static GColor bg_ink;
+static GFont bg_font, time_font;
 
 static char last_bg[124];
+static BgStoreState last_state;
+static bool has_stored_state = false;
 static int data_id = 99;
 static char time_delta_str[124] = "";
 static char time_text[124] = "";
 
 static ChartLayer* chart_layer;
 
+#if CGM_PERF
+static TextLayer * perf_layer;
+static char perf_text[128] = "";
+#endif
+
 enum CgmKey {
     CGM_EGV_DELTA_KEY = 0x0,
     CGM_EGV_KEY = 0x1,
@@ -55,7 +88,9 @@ enum CgmKey {
     CGM_ID = 0x5,
     CGM_TIME_DELTA_KEY = 0x6,
     CGM_BGS = 0x7,
-    CGM_BG_TIMES = 0x8
+    CGM_SYNC_SINCE = 0x9,
+    CGM_SYNC_VERSION = 0xA,
+    CGM_PUSH = 0xB
 };
 
 enum Alerts {
@@ -71,17 +106,6 @@ static int b_color_channels[3] = { 0, 0, 0 };
 
 static const uint32_t const error[] = { 100, 100, 100, 100, 100 };
 
-static const uint32_t CGM_ICONS[] = {
-        RESOURCE_ID_IMAGE_NONE_WHITE,	  //4 - 0
-        RESOURCE_ID_IMAGE_UPUP_WHITE,     //0 - 1
-        RESOURCE_ID_IMAGE_UP_WHITE,       //1 - 2
-        RESOURCE_ID_IMAGE_UP45_WHITE,     //2 - 3
-        RESOURCE_ID_IMAGE_FLAT_WHITE,     //3 - 4
-        RESOURCE_ID_IMAGE_DOWN45_WHITE,   //5 - 5
-        RESOURCE_ID_IMAGE_DOWN_WHITE,     //6 - 6
-        RESOURCE_ID_IMAGE_DOWNDOWN_WHITE,  //7 - 7
-        };
-
 char *translate_error(AppMessageResult result) {
     switch (result) {
         case APP_MSG_OK:
@@ -117,26 +141,62 @@ char *translate_error(AppMessageResult result) {
     }
 }
 
+/**
+ * Sets the background colour. On colour platforms the spark line's canvas follows it; the chart caches its drawing,
+ * so this is only passed on when the colour actually changes rather than on every frame.
+ */
+static void set_background(int red, int green, int blue) {
+    b_color_channels[0] = red;
+    b_color_channels[1] = green;
+    b_color_channels[2] = blue;
+#if defined(PBL_PLATFORM_BASALT) || defined(PBL_PLATFORM_CHALK)
+    if (chart_layer) {
+        chart_layer_set_canvas_color(chart_layer, GColorFromRGB(red, green, blue));
+    }
+#endif
+    layer_mark_dirty(s_canvas_layer);
+}
+
 /**
  * Alert the user to a network or device communication error.
+ * @param failures The number of failed fetches in a row, or 0 to always vibrate.
  */
-static void comm_alert() {
+static void comm_alert(int failures) {
     VibePattern pattern = {
             .durations = error,
             .num_segments = ARRAY_LENGTH(error),
     };
 
     // Vibrate every 5th time we have a communications error to reduce annoyance factor
-    if (check_count % 1 == 0 || t_delta % 1 == 0) {
+    if (failures % 5 == 0) {
         vibes_enqueue_custom_pattern(pattern);
     }
 
     // set the background to red?
-    b_color_channels[0] = 255;
-    b_color_channels[1] = 0;
-    b_color_channels[2] = 0;
+    set_background(255, 0, 0);
+}
 
-    layer_mark_dirty(s_canvas_layer);
+/********************************** History ***********************************/
+
+/**
+ * Time of the newest reading held on the watch, or 0 if we hold none. This is sent to the phone so that it only
+ * replies with readings we don't have yet.
+ */
+static uint32_t history_newest() {
+    const BgRecord *latest = bg_history_latest();
+    return latest ? latest->time : 0;
+}
+
+/**
+ * Minutes since the newest reading we hold, or -1 if we hold none.
+ */
+static int history_age_minutes() {
+    uint32_t newest = history_newest();
+    if (!newest) {
+        return -1;
+    }
+    time_t now = time(NULL);
+    return (now > (time_t) newest) ? (int) ((now - newest) / 60) : 0;
 }
 
 /************************************ UI **************************************/
@@ -147,12 +207,224 @@ static void send_int(int key, int value) {
     app_message_outbox_send();
 }
 
+/**
+ * Asks the phone for data, telling it the newest reading we already hold and which history packet version we speak.
+ */
+static void send_request() {
+    DictionaryIterator *iter;
+    app_message_outbox_begin(&iter);
+    dict_write_int(iter, CGM_ID, &data_id, sizeof(int), true);
+    dict_write_uint32(iter, CGM_SYNC_SINCE, history_newest());
+    dict_write_uint8(iter, CGM_SYNC_VERSION, BG_PACKET_VERSION);
+    app_message_outbox_send();
+}
+
 void send_cmd_connect() {
     data_id = 69;
     send_int(5, data_id);
 }
 
 
+#if TREND_ICONS_PDC
+static bool paint_command(GDrawCommand *command, uint32_t index, void *context) {
+    GColor ink = *(GColor *) context;
+    if (gdraw_command_get_fill_color(command).a) {
+        gdraw_command_set_fill_color(command, ink);
+    }
+    if (gdraw_command_get_stroke_color(command).a) {
+        gdraw_command_set_stroke_color(command, ink);
+    }
+    return true;
+}
+
+/**
+ * Draws the current frame of the trend glyph sequence in the icon ink. The glyphs are recoloured in place, so the
+ * frame is only walked when the ink or the icon changed since it was last drawn.
+ */
+static void icon_update_proc(Layer * layer, GContext * ctx) {
+    static GDrawCommandFrame *painted_frame = NULL;
+    static GColor painted_ink;
+
+    GDrawCommandFrame *frame = trend_glyphs ? gdraw_command_sequence_get_frame_by_index(trend_glyphs, icon_index) : NULL;
+    if (!frame) {
+        return;
+    }
+    if (frame != painted_frame || !gcolor_equal(icon_ink, painted_ink)) {
+        gdraw_command_list_iterate(gdraw_command_frame_get_command_list(frame), paint_command, &icon_ink);
+        painted_frame = frame;
+        painted_ink = icon_ink;
+    }
+    gdraw_command_frame_draw(ctx, trend_glyphs, frame, GPointZero);
+}
+
+/**
+ * Loads the trend glyphs once; they are drawn straight from the resource's command lists, with no bitmap to decode.
+ */
+static void load_trend_icons() {
+    trend_glyphs = gdraw_command_sequence_create_with_resource(RESOURCE_ID_IMAGE_TRENDS_PDC);
+}
+
+static void unload_trend_icons() {
+    if (trend_glyphs) {
+        gdraw_command_sequence_destroy(trend_glyphs);
+        trend_glyphs = NULL;
+    }
+}
+
+/**
+ * Shows the icon at `index` in the trend glyph sequence.
+ */
+static void show_icon(int index) {
+    icon_index = index;
+    if (icon_layer) {
+        layer_mark_dirty(icon_layer);
+    }
+}
+
+/**
+ * Sets the colour the trend icon is drawn in; it follows the BG text, so it stands out from the alert box.
+ */
+static void set_icon_ink(GColor ink) {
+    if (gcolor_equal(ink, icon_ink)) {
+        return;
+    }
+    icon_ink = ink;
+    if (icon_layer) {
+        layer_mark_dirty(icon_layer);
+    }
+}
+#else
+/**
+ * Loads the trend icon atlas once and carves it into one sub-bitmap per icon, so changing the icon is only a matter
+ * of pointing the icon layer at another one.
+ */
+static void load_trend_icons() {
+    trend_atlas = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_TRENDS_WHITE);
+    for (int i = 0; i <= TREND_ICON_COUNT; i++) {
+        trend_icons[i] = trend_atlas
+                ? gbitmap_create_as_sub_bitmap(trend_atlas, GRect(0, i * TREND_ICON_SIZE, TREND_ICON_SIZE, TREND_ICON_SIZE))
+                : NULL;
+    }
+}
+
+static void unload_trend_icons() {
+    for (int i = 0; i <= TREND_ICON_COUNT; i++) {
+        if (trend_icons[i]) {
+            gbitmap_destroy(trend_icons[i]);
+            trend_icons[i] = NULL;
+        }
+    }
+    if (trend_atlas) {
+        gbitmap_destroy(trend_atlas);
+        trend_atlas = NULL;
+    }
+}
+
+/**
+ * Shows the icon at `index` in the trend icon atlas.
+ */
+static void show_icon(int index) {
+    if (icon_layer) {
+        bitmap_layer_set_bitmap(icon_layer, trend_icons[index]);
+    }
+}
+
+/**
+ * Sets the colour the white trend icons are drawn in, by compositing them either as they are or inverted.
+ */
+static void set_icon_ink(GColor ink) {
+    safe_bitmap_layer_set_compositing_mode(icon_layer, gcolor_equal(ink, GColorWhite) ? GCompOpOr : GCompOpClear);
+}
+#endif
+
+/**
+ * Loads the custom fonts for the lifetime of the window. The resources are subset with characterRegex in appinfo.json
+ * to what the layers using them show: the BG readings and the short status and error codes sent in their place, and
+ * the wall clock time and date. The BG font is only loaded while it is needed; see update_bg_font.
+ */
+static void load_fonts() {
+    time_font = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_LATO_BOLD_18));
+}
+
+static void unload_fonts() {
+    if (bg_font) {
+        fonts_unload_custom_font(bg_font);
+        bg_font = NULL;
+    }
+    fonts_unload_custom_font(time_font);
+}
+
+/**
+ * The glyph atlas draws the readings and status words, so the BG font is only held while the text is something it
+ * does not cover, such as an error code, rather than taking heap alongside the atlas all the time.
+ */
+static void update_bg_font(const char *text) {
+    bool needed = text && !bg_glyphs_can_draw(text);
+    if (needed && !bg_font) {
+        bg_font = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_HN_BOLD_48));
+    } else if (!needed && bg_font) {
+        fonts_unload_custom_font(bg_font);
+        bg_font = NULL;
+    }
+}
+
+/**
+ * Draws the BG reading, or the status word sent in its place. Anything the pre-rendered glyphs cover is copied
+ * straight into the alert box; the rest, such as the error codes, goes through the font as a text layer would.
+ */
+static void bg_update_proc(Layer * layer, GContext * ctx) {
+    GRect bounds = layer_get_bounds(layer);
+    if (bg_glyphs_can_draw(bg_text)) {
+        bg_glyphs_draw(ctx, bounds, bg_text, bg_ink);
+    } else if (bg_text && bg_font) {
+        graphics_context_set_text_color(ctx, bg_ink);
+        graphics_draw_text(ctx, bg_text, bg_font, bounds, GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+    }
+}
+
+/**
+ * Sets the text of the BG reading. Like text_layer_set_text, the text is not copied and must outlive the next redraw.
+ */
+static void set_bg_text(const char *text) {
+    bg_text = text;
+    if (bg_layer) {
+        update_bg_font(text);
+        layer_mark_dirty(bg_layer);
+    }
+}
+
+static void set_bg_ink(GColor ink) {
+    if (gcolor_equal(ink, bg_ink)) {
+        return;
+    }
+    bg_ink = ink;
+    if (bg_layer) {
+        layer_mark_dirty(bg_layer);
+    }
+}
+
+/**
+ * Shows the arrow for a trend value from the phone.
+ */
+static void set_trend_icon(uint8_t trend) {
+    if (trend >= TREND_ICON_COUNT) {
+        trend = 0;
+    }
+    show_icon(trend);
+}
+
+/**
+ * This method updates the time_delta_str text field to display the age of the data, "now" or "N min".
+ */
+void displayAgeText(int minutes) {
+    if (minutes <= 0) {
+        snprintf(time_delta_str, 12, "now"); // puts string into buffer
+    } else {
+        snprintf(time_delta_str, 12, "%d min", minutes); // puts string into buffer
+    }
+    safe_text_layer_set_text(time_delta_layer, time_delta_str);
+}
+
 /**
  * This method updates the time_delta_str text field to display the "loading..." message. If it a retry, it will
  * print the retry count. If it is one of the first two attempts, it will simply do an ellipsis as it will often
@@ -171,18 +443,17 @@ void send_cmd() {
     //APP_LOG(APP_LOG_LEVEL_INFO, "send_cmd");
 
     if (s_canvas_layer) {
-        gbitmap_destroy(icon_bitmap);
+        int failures = fetch_scheduler_failures();
+        displayLoadingText(failures);
 
-        displayLoadingText(check_count++);
-
-        // if we've tried loading more than once, that means there's some network/connection issue
-        if (check_count > 1) {
+        // if a fetch has failed already, that means there's some network/connection issue
+        if (failures > 0) {
             data_id = 99;
         }
 
-        // if we've failed more than four times, alert the user
-        if (check_count > 4) {
-            comm_alert();
+        // if we've failed more than three times, alert the user
+        if (failures > 3) {
+            comm_alert(failures);
         }
 
         // If we've initialized the element to write the Loading string to, update it
@@ -191,27 +462,25 @@ void send_cmd() {
         }
 
         // show the icon of the cloud with the refresh cycle
-        icon_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_REFRESH_WHITE);
-        if (icon_layer) {
-            bitmap_layer_set_bitmap(icon_layer, icon_bitmap);
-        }
+        show_icon(TREND_ICON_REFRESH);
     }
 
-    send_int(5, data_id);
+    send_request();
 
     //APP_LOG(APP_LOG_LEVEL_INFO, "Message sent!");
-    //APP_LOG(APP_LOG_LEVEL_INFO, "check_count: %d", check_count);
-}
-
-/*************Startup Timer*******/
-//Message SHOULD come from smartphone app, but this will kick it off in less than 60 seconds if it can.
-static void timer_callback(void *data) {
-    send_cmd();
 }
 
-static void timer_callback_2(void *data) {
-    //send_cmd_connect();
-    //timer2 = app_timer_register(60000*2, timer_callback_2, NULL);
+/**
+ * Called by the fetch scheduler whenever data is due from the phone.
+ */
+static void fetch_data() {
+    if (has_stored_state) {
+        // the last known state is already on screen, so the first fetch refreshes it quietly in the background
+        has_stored_state = false;
+        send_request();
+    } else {
+        send_cmd();
+    }
 }
 
 /**
@@ -269,156 +538,174 @@ static void clock_refresh(struct tm * tick_time) {
  *    Loading: "check(#)"
  */
 static void tick_handler(struct tm * tick_time, TimeUnits changed) {
-    if (!has_launched) {
+    // the age of the newest reading we hold is authoritative; without one, count the minutes since the last reply
+    int age = history_age_minutes();
+
+    // fetching is left to the fetch scheduler; this only keeps the text current
+    if (!has_launched || fetch_scheduler_failures() > 0) {
     
-        displayLoadingText(check_count + 1);
+        displayLoadingText(fetch_scheduler_failures() + 1);
 
         if (time_delta_layer) {
             text_layer_set_text(time_delta_layer, time_delta_str);
         }
     } else {
-        if (t_delta > retry_interval || check_count > 1) {
-            send_cmd();
-        } else {
-            if (has_launched) {
-                if (t_delta <= 0) {
-                    t_delta = 0;
-                    snprintf(time_delta_str, 12, "now"); // puts string into buffer
-                } else {
-                    snprintf(time_delta_str, 12, "%d min", t_delta); // puts string into buffer
-                }
-                if (time_delta_layer) {
-                    text_layer_set_text(time_delta_layer, time_delta_str);
-                }
-            } else {
+        if (age >= 0) {
+            t_delta = age;
+        }
 
-            }
+        if (t_delta <= 0) {
+            t_delta = 0;
         }
+        displayAgeText(t_delta);
+    }
+    if (age < 0) {
+        t_delta++;
     }
-    t_delta++;
     clock_refresh(tick_time);
 
 }
 
+#ifdef PBL_PLATFORM_CHALK
 /**
- * This method is called automatically by the Pebble when the canvas layer needs to be updated.
- * Updates can be triggered by marking the canvas layer as dirty, e.g. `layer_mark_dirty(s_canvas_layer);`
- * The parent process will then issue a call to this method to refresh the layer's contents.
+ * The round face's top and bottom bands are the visible arcs of radius 240 circles centred far off screen. Rasterizing
+ * the circles walks far more than what shows, so the arcs are turned into paths once, when the window loads, and each
+ * band is drawn as a filled path plus an open path for its edge.
  */
-static void update_proc(Layer * layer, GContext * ctx) {
-
-#ifdef PBL_PLATFORM_BASALT
-    // draw a white border for the wall clock time and BG value (aka everything above the spark line)
-    graphics_context_set_fill_color(ctx, GColorFromRGB(b_color_channels[0], b_color_channels[1], b_color_channels[2]));
-    graphics_fill_rect(ctx, GRect(0, 0, 144, 168), 0, GCornerNone);
-
-    graphics_context_set_stroke_color(ctx, GColorBlack);
-    graphics_context_set_antialiased(ctx, ANTIALIASING);
-
-    // draw the white box at the top for the wall clock time
-    graphics_context_set_fill_color(ctx, GColorWhite);
-    graphics_fill_rect(ctx, GRect(0, 0, 144, 25), 0, GCornerNone);
+#define BAND_RADIUS 240
+#define BAND_STEP 6
+#define BAND_ARC_POINTS (180 / BAND_STEP + 1)
+
+static GPoint s_top_band_points[BAND_ARC_POINTS + 2], s_top_edge_points[BAND_ARC_POINTS];
+static GPoint s_bottom_band_points[BAND_ARC_POINTS + 2], s_bottom_edge_points[BAND_ARC_POINTS];
+static GPathInfo s_top_band_info = { BAND_ARC_POINTS + 2, s_top_band_points };
+static GPathInfo s_top_edge_info = { BAND_ARC_POINTS, s_top_edge_points };
+static GPathInfo s_bottom_band_info = { BAND_ARC_POINTS + 2, s_bottom_band_points };
+static GPathInfo s_bottom_edge_info = { BAND_ARC_POINTS, s_bottom_edge_points };
+static GPath *s_top_band, *s_top_edge, *s_bottom_band, *s_bottom_edge;
+
+static int isqrt(int n) {
+    int root = 0, bit = 1 << 30;
+    while (bit > n) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
 
-    // draw the main colored box (green, red, yellow); note this is the visual key that the entire experience hinges on
-    graphics_context_set_fill_color(ctx, GColorFromRGB(s_color_channels[0], s_color_channels[1], s_color_channels[2]));
-    graphics_fill_rect(ctx, GRect(0, 24, 144, 74), 4, GCornersAll);
-    graphics_context_set_stroke_color(ctx, GColorWhite);
-    graphics_context_set_stroke_width(ctx, 2);
-    graphics_draw_round_rect(ctx, GRect(0, 24, 144, 74), 4); // overlay the edge on top of the wall clock time
+/**
+ * The y coordinate at x of a band circle centred on the middle column, on its lower (sign 1) or upper (sign -1) half.
+ */
+static int band_arc_y(int centre_y, int sign, int x) {
+    int dx = x - 90;
+    return centre_y + sign * isqrt(BAND_RADIUS * BAND_RADIUS - dx * dx);
+}
 
-    // if we have a spark line layer, render it
-    if(chart_layer) {
-        chart_layer_set_canvas_color(chart_layer, GColorFromRGB(b_color_channels[0], b_color_channels[1], b_color_channels[2]));
+static void create_band_paths() {
+    for (int i = 0; i < BAND_ARC_POINTS; i++) {
+        int x = i * BAND_STEP;
+        // the top band runs right to left along its arc and closes over the top corners
+        s_top_band_points[i] = GPoint(180 - x, band_arc_y(-200, 1, 180 - x));
+        s_top_edge_points[i] = GPoint(x, band_arc_y(-199, 1, x));
+        // the bottom band runs left to right and closes under the bottom corners
+        s_bottom_band_points[i] = GPoint(x, band_arc_y(377, -1, x));
+        s_bottom_edge_points[i] = GPoint(x, band_arc_y(376, -1, x));
     }
-#elif PBL_PLATFORM_CHALK
+    s_top_band_points[BAND_ARC_POINTS] = GPoint(0, 0);
+    s_top_band_points[BAND_ARC_POINTS + 1] = GPoint(180, 0);
+    s_bottom_band_points[BAND_ARC_POINTS] = GPoint(180, 180);
+    s_bottom_band_points[BAND_ARC_POINTS + 1] = GPoint(0, 180);
+
+    s_top_band = gpath_create(&s_top_band_info);
+    s_top_edge = gpath_create(&s_top_edge_info);
+    s_bottom_band = gpath_create(&s_bottom_band_info);
+    s_bottom_edge = gpath_create(&s_bottom_edge_info);
+}
 
+static void destroy_band_paths() {
+    gpath_destroy(s_top_band);
+    gpath_destroy(s_top_edge);
+    gpath_destroy(s_bottom_band);
+    gpath_destroy(s_bottom_edge);
+}
+#endif
+
+/**
+ * The face is drawn by three layers stacked under the text layers, each invalidated on its own:
+ * - s_canvas_layer paints the background colour, but only where the other two leave it showing;
+ * - s_alert_layer paints the alert box in the alert colour;
+ * - s_clock_band_layer paints the band behind the wall clock time, which never changes.
+ * Mark the layer whose colour changed dirty rather than the whole canvas.
+ */
+static void update_proc(Layer * layer, GContext * ctx) {
+    CGM_PERF_SCOPE(CGM_PERF_UPDATE_PROC);
     graphics_context_set_fill_color(ctx, GColorFromRGB(b_color_channels[0], b_color_channels[1], b_color_channels[2]));
-    graphics_fill_rect(ctx, GRect(0, 0, 180, 180), 0, GCornerNone);
+#ifdef PBL_PLATFORM_CHALK
+    // everything above the spark line is covered by the alert box
+    graphics_fill_rect(ctx, GRect(0, 86, 180, 94), 0, GCornerNone);
+#else
+    // the alert box covers the middle, except for its rounded corners
+    graphics_fill_rect(ctx, GRect(0, 24, 144, 4), 0, GCornerNone);
+    graphics_fill_rect(ctx, GRect(0, 94, 144, 74), 0, GCornerNone);
+#endif
+}
 
-    graphics_context_set_stroke_color(ctx, GColorBlack);
+/**
+ * Draws the main coloured box (green, red, yellow); note this is the visual key that the entire experience hinges on.
+ */
+static void alert_update_proc(Layer * layer, GContext * ctx) {
+    GColor alert_color = GColorFromRGB(s_color_channels[0], s_color_channels[1], s_color_channels[2]);
     graphics_context_set_antialiased(ctx, ANTIALIASING);
-
-    graphics_context_set_fill_color(ctx, GColorFromRGB(s_color_channels[0], s_color_channels[1], s_color_channels[2]));
+    graphics_context_set_fill_color(ctx, alert_color);
+#ifdef PBL_PLATFORM_CHALK
     graphics_fill_rect(ctx, GRect(-5, 0, 185, 90), 4, GCornersAll);
-    //graphics_context_set_stroke_color(ctx, GColorLightGray); 
-    //graphics_context_set_stroke_width(ctx, 2);
-    //graphics_draw_round_rect(ctx, GRect(-5, 0, 185, 86), 4);
-    //graphics_draw_round_rect(ctx, GRect(-5, 137, 185, 71), 4);
 
+    // the band at the bottom, behind the wall clock time
     graphics_context_set_stroke_width(ctx, 2);
-    graphics_context_set_stroke_color (ctx,GColorBlack);
-    graphics_draw_circle(ctx, GPoint(90, -199), 240);
-    graphics_context_set_fill_color(ctx, GColorWhite);
-    graphics_fill_circle(ctx, GPoint(90, -200), 240);
-    //graphics_context_set_stroke_width(ctx, 1);
-    graphics_context_set_stroke_color(ctx, GColorFromRGB(s_color_channels[0], s_color_channels[1], s_color_channels[2]));
-    graphics_draw_circle(ctx, GPoint(90, 376), 240);
-    graphics_fill_circle(ctx, GPoint(90, 377), 240);
-
-    if(chart_layer) {
-        chart_layer_set_canvas_color(chart_layer, GColorFromRGB(b_color_channels[0], b_color_channels[1], b_color_channels[2]));
-    }
+    graphics_context_set_stroke_color(ctx, alert_color);
+    gpath_draw_outline_open(ctx, s_bottom_edge);
+    gpath_draw_filled(ctx, s_bottom_band);
 #else
-    graphics_context_set_fill_color(ctx, GColorFromRGB(b_color_channels[0], b_color_channels[1], b_color_channels[2]));
-    graphics_fill_rect(ctx, GRect(0, 0, 144, 168), 0, GCornerNone);
+    // the layer starts two pixels up so the edge overlays the wall clock band
+    graphics_fill_rect(ctx, GRect(0, 2, 144, 74), 4, GCornersAll);
+    graphics_context_set_stroke_color(ctx, GColorWhite);
+    graphics_context_set_stroke_width(ctx, 2);
+    graphics_draw_round_rect(ctx, GRect(0, 2, 144, 74), 4);
+#endif
+}
 
-    graphics_context_set_stroke_color(ctx, GColorBlack);
+/**
+ * Draws the white band at the top, behind the wall clock time on rectangular watches and the age and delta on round
+ * ones.
+ */
+static void clock_band_update_proc(Layer * layer, GContext * ctx) {
+#ifdef PBL_PLATFORM_CHALK
     graphics_context_set_antialiased(ctx, ANTIALIASING);
-
+    graphics_context_set_stroke_width(ctx, 2);
+    graphics_context_set_stroke_color(ctx, GColorBlack);
+    gpath_draw_outline_open(ctx, s_top_edge);
+    graphics_context_set_fill_color(ctx, GColorWhite);
+    gpath_draw_filled(ctx, s_top_band);
+#else
     graphics_context_set_fill_color(ctx, GColorWhite);
     graphics_fill_rect(ctx, GRect(0, 0, 144, 25), 0, GCornerNone);
-
-    graphics_context_set_fill_color(ctx, GColorFromRGB(s_color_channels[0], s_color_channels[1], s_color_channels[2]));
-    graphics_fill_rect(ctx, GRect(0, 24, 144, 74), 4, GCornersAll);
-    graphics_context_set_stroke_color(ctx, GColorWhite);
-    graphics_context_set_stroke_width(ctx, 2);
-    graphics_draw_round_rect(ctx, GRect(0, 24, 144, 74), 4);
-    // //Change Background
-    // if (b_color_channels[0] == 170) {
-    //     //OKAY
-    //     graphics_context_set_fill_color(ctx, GColorWhite);
-    //     graphics_fill_rect(ctx, GRect(0, 0, 144, 168), 0, GCornerNone);
-    //     if(time_layer)
-    //         text_layer_set_text_color(time_layer, GColorBlack);
-    // } else {
-    //     //BAD COMMS
-    //     graphics_context_set_fill_color(ctx, GColorBlack);
-    //     graphics_fill_rect(ctx, GRect(0, 0, 144, 168), 0, GCornerNone);
-    //     if(time_layer)
-    //         text_layer_set_text_color(time_layer, GColorBlack);
-    // }
-    // Change clockface colors
-    // if we are on a non-red face, use black
-    if (s_color_channels[0] < 255) {
-        //OKAY      
-        safe_text_layer_set_text_color(bg_layer, GColorBlack);
-        safe_text_layer_set_text_color(delta_layer, GColorBlack);
-        safe_text_layer_set_text_color(time_delta_layer, GColorBlack);
-        safe_bitmap_layer_set_compositing_mode(icon_layer, GCompOpClear);
-    } else {
-        // in an error state, invert text color to white
-        safe_text_layer_set_text_color(bg_layer, GColorWhite);
-        safe_text_layer_set_text_color(delta_layer, GColorWhite);
-        safe_text_layer_set_text_color(time_delta_layer, GColorWhite);
-        safe_bitmap_layer_set_compositing_mode(icon_layer, GCompOpOr);
-    }
-    // graphics_fill_rect(ctx, GRect(0, 24, 144, 74), 0, GCornerNone);
 #endif
-
 }
 
 /**
  * Sometimes, you just need a fresh start, particularly when coming out of error mode into normal operating conditions.
  */
 static void reset_background() {
-    b_color_channels[0] = 0;
-    b_color_channels[1] = 0;
-    b_color_channels[2] = 0;
     safe_text_layer_set_text_color(time_layer, GColorBlack);
-    if (chart_layer) {
-        chart_layer_set_canvas_color(chart_layer, GColorBlack);
-    }
-    layer_mark_dirty(s_canvas_layer);
+    set_background(0, 0, 0);
 }
 
 /**
@@ -427,14 +714,14 @@ static void reset_background() {
 bool is_snoozed() {
     time_t t = time(NULL);
     if (t > alert_snooze) {
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Snooze Expire");
+        CGM_LOG_DEBUG(ALERT, "Snooze Expire");
         return false;
     }
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "Snooze Active");
+    CGM_LOG_DEBUG(ALERT, "Snooze Active");
     return true;
 }
 
-static void process_alert() {
+static void process_alert(bool vibrate) {
     //APP_LOG(APP_LOG_LEVEL_DEBUG, "Vibe State: %i", vibe_state);
     switch (alert_state) {
 
@@ -444,30 +731,30 @@ static void process_alert() {
             s_color_channels[1] = 255;
             s_color_channels[2] = 0;
 
-            if (vibe_state > 0 && !is_snoozed())
+            if (vibrate && vibe_state > 0 && !is_snoozed())
                 vibes_long_pulse();
 
             //APP_LOG(APP_LOG_LEVEL_DEBUG, "Alert key: %i", LOSS_MID_NO_NOISE);
 #if defined(PBL_COLOR)
-            safe_text_layer_set_text_color(bg_layer, GColorBlack);
+            set_bg_ink(GColorBlack);
 #ifdef PBL_PLATFORM_CHALK 
-            safe_text_layer_set_text_color(bg_layer, GColorBlack);
+            set_bg_ink(GColorBlack);
             safe_text_layer_set_text_color(delta_layer, GColorBlack);
             safe_text_layer_set_text_color(time_delta_layer, GColorBlack);
 #else 
-            safe_text_layer_set_text_color(bg_layer, GColorBlack);
+            set_bg_ink(GColorBlack);
             safe_text_layer_set_text_color(delta_layer, GColorBlack);
             safe_text_layer_set_text_color(time_delta_layer, GColorBlack);
 #endif
-            safe_bitmap_layer_set_compositing_mode(icon_layer, GCompOpClear);
+            set_icon_ink(GColorBlack);
 #elif defined(PBL_BW)
             s_color_channels[0] = 170;
             s_color_channels[1] = 170;
             s_color_channels[2] = 170;
-            safe_text_layer_set_text_color(bg_layer, GColorBlack);
+            set_bg_ink(GColorBlack);
             safe_text_layer_set_text_color(delta_layer, GColorBlack);
             safe_text_layer_set_text_color(time_delta_layer, GColorBlack);
-            safe_bitmap_layer_set_compositing_mode(icon_layer, GCompOpClear);
+            set_icon_ink(GColorBlack);
 #endif
 
             break;
@@ -478,7 +765,7 @@ static void process_alert() {
             s_color_channels[1] = 0;
             s_color_channels[2] = 0;
 
-            if (vibe_state > 0 && !is_snoozed()) {
+            if (vibrate && vibe_state > 0 && !is_snoozed()) {
                 vibes_long_pulse();
             }
 
@@ -490,8 +777,8 @@ static void process_alert() {
             safe_text_layer_set_text_color(time_delta_layer, GColorWhite);
 #endif
 
-            safe_text_layer_set_text_color(bg_layer, GColorWhite);
-            safe_bitmap_layer_set_compositing_mode(icon_layer, GCompOpOr);
+            set_bg_ink(GColorWhite);
+            set_icon_ink(GColorWhite);
             break;
 
         case OKAY:
@@ -501,12 +788,12 @@ static void process_alert() {
             s_color_channels[1] = 255;
             s_color_channels[2] = 0;
 
-            if (vibe_state > 1 && !is_snoozed()) {
+            if (vibrate && vibe_state > 1 && !is_snoozed()) {
                 vibes_double_pulse();
             }
 
             //APP_LOG(APP_LOG_LEVEL_DEBUG, "Alert key: %i", OKAY);
-            safe_text_layer_set_text_color(bg_layer, GColorBlack);
+            set_bg_ink(GColorBlack);
 #ifdef PBL_PLATFORM_CHALK
             safe_text_layer_set_text_color(delta_layer, GColorBlack);
             safe_text_layer_set_text_color(time_delta_layer, GColorBlack);
@@ -514,13 +801,15 @@ static void process_alert() {
             safe_text_layer_set_text_color(delta_layer, GColorBlack);
             safe_text_layer_set_text_color(time_delta_layer, GColorBlack);
 #endif
-            safe_bitmap_layer_set_compositing_mode(icon_layer, GCompOpClear);
+            set_icon_ink(GColorBlack);
             break;
 
         case OLD_DATA:
             ;
 
-            comm_alert();
+            if (vibrate) {
+                comm_alert(0);
+            }
             //APP_LOG(APP_LOG_LEVEL_DEBUG, "Alert key: %i", OLD_DATA);
 
             s_color_channels[0] = 0;
@@ -535,21 +824,104 @@ static void process_alert() {
             safe_text_layer_set_text_color(time_delta_layer, GColorWhite);
 #endif
 
-            safe_bitmap_layer_set_compositing_mode(icon_layer, GCompOpOr);
-            safe_text_layer_set_text_color(bg_layer, GColorWhite);
+            set_icon_ink(GColorWhite);
+            set_bg_ink(GColorWhite);
 
             break;
 
         case NO_CHANGE:
             ;
-            break;
+            return;
+    }
+
+#if !defined(PBL_PLATFORM_BASALT) && !defined(PBL_PLATFORM_CHALK)
+    // on black and white the text only has to stand out from the alert box: white on red, black otherwise
+    if (s_color_channels[0] < 255) {
+        set_bg_ink(GColorBlack);
+        safe_text_layer_set_text_color(delta_layer, GColorBlack);
+        safe_text_layer_set_text_color(time_delta_layer, GColorBlack);
+        set_icon_ink(GColorBlack);
+    } else {
+        set_bg_ink(GColorWhite);
+        safe_text_layer_set_text_color(delta_layer, GColorWhite);
+        safe_text_layer_set_text_color(time_delta_layer, GColorWhite);
+        set_icon_ink(GColorWhite);
     }
+#endif
+
+    if (s_alert_layer) {
+        layer_mark_dirty(s_alert_layer);
+    }
+}
 
+#if CGM_PERF
+/**
+ * Refreshes the debug overlay, if it is showing, with the rolling min/avg/max of every metric.
+ */
+static void update_perf_overlay() {
+    if (perf_layer && !layer_get_hidden(text_layer_get_layer(perf_layer))) {
+        cgm_perf_format(perf_text, sizeof(perf_text));
+        text_layer_set_text(perf_layer, perf_text);
+    }
+}
+
+/**
+ * A tap on the watch toggles the debug overlay and sends the full report to the phone log.
+ */
+static void perf_tap_handler(AccelAxisType axis, int32_t direction) {
+    if (perf_layer) {
+        Layer *layer = text_layer_get_layer(perf_layer);
+        layer_set_hidden(layer, !layer_get_hidden(layer));
+        update_perf_overlay();
+    }
+    cgm_perf_log_report();
+}
+#endif
+
+/**
+ * Handles a NO_CHANGE reply: the phone's newest reading is the one we already show, so only its age has moved on.
+ * The trend icon and BG text are put back from last_state, since send_cmd replaces them while it waits; the rest of
+ * the face, the history and the chart are left alone.
+ * @return true if the reply was a NO_CHANGE one and has been handled.
+ */
+static bool handle_no_change(DictionaryIterator *iterator) {
+    Tuple *alert = dict_find(iterator, CGM_ALERT_KEY);
+    if (!alert || alert->value->uint8 != NO_CHANGE) {
+        return false;
+    }
+
+    set_trend_icon(last_state.trend);
+    set_bg_text(last_state.egv);
+
+    Tuple *age = dict_find(iterator, CGM_TIME_DELTA_KEY);
+    if (age && age->value->int16 >= 0) {
+        t_delta = age->value->int16;
+    }
+    displayAgeText(t_delta);
+
+    CGM_LOG_DEBUG(APP, "no change, %i min", t_delta);
+    return true;
 }
 
 static void inbox_received_callback(DictionaryIterator *iterator, void *context) {
-    check_count = 0;
+    CGM_PERF_SCOPE(CGM_PERF_INBOX);
     //APP_LOG(APP_LOG_LEVEL_INFO, "Message received!");
+    uint32_t dict = dict_size(iterator);
+    CGM_PERF_RECORD(CGM_PERF_MESSAGE_BYTES, dict);
+
+    // a phone that no longer pushes (restarted, or replying to a request of ours) leaves the key out
+    Tuple *push = dict_find(iterator, CGM_PUSH);
+    fetch_scheduler_set_push(push && push->value->uint8);
+
+    if (handle_no_change(iterator)) {
+        has_launched = 1;
+        fetch_scheduler_on_reply(history_newest());
+#if CGM_PERF
+        update_perf_overlay();
+#endif
+        return;
+    }
+
     if (time_delta_layer) {
         text_layer_set_text(time_delta_layer, "in...");
     }
@@ -557,10 +929,11 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
     // Get the first pair
     Tuple *new_tuple = dict_read_first(iterator);
 
-    uint32_t dict = dict_size(iterator);
     //APP_LOG(APP_LOG_LEVEL_INFO, "size of received: %d", (int)dict);
     reset_background();
     CgmData* cgm_data = cgm_data_create(1, 2, "3m", "199", "+3mg/dL", "Evan");
+    bool has_history_update = false;
+    bool rebuild_chart = false;
 
     // Process all pairs present
     while (new_tuple != NULL) {
@@ -575,29 +948,27 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
             case CGM_EGV_DELTA_KEY:
                 ;
                 safe_text_layer_set_text(delta_layer, new_tuple->value->cstring);
+                strncpy(last_state.delta, new_tuple->value->cstring, BG_STORE_DELTA_LENGTH - 1);
                 break;
 
             case CGM_EGV_KEY:
                 ;
                 cgm_data_set_egv(cgm_data, new_tuple->value->cstring);
-                safe_text_layer_set_text(bg_layer, cgm_data_get_egv(cgm_data));
+                set_bg_text(cgm_data_get_egv(cgm_data));
                 strncpy(last_bg, new_tuple->value->cstring, 124);
+                strncpy(last_state.egv, new_tuple->value->cstring, BG_STORE_EGV_LENGTH - 1);
                 break;
 
             case CGM_TREND_KEY:
                 ;
-                if (icon_bitmap) {
-                    gbitmap_destroy(icon_bitmap);
-                }
-                icon_bitmap = gbitmap_create_with_resource(CGM_ICONS[new_tuple->value->uint8]);
-                if (icon_layer) {
-                    bitmap_layer_set_bitmap(icon_layer, icon_bitmap);
-                }
+                set_trend_icon(new_tuple->value->uint8);
+                last_state.trend = new_tuple->value->uint8;
                 break;
 
             case CGM_ALERT_KEY:
                 ;
                 alert_state = new_tuple->value->uint8;
+                last_state.alert = alert_state;
                 break;
 
             case CGM_VIBE_KEY:
@@ -616,41 +987,19 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
 
                 if (t_delta <= 0) {
                     t_delta = 0;
-                    snprintf(time_delta_str, 12, "now"); // puts string into buffer
-                } else {
-                    snprintf(time_delta_str, 12, "%d min", t_delta); // puts string into buffer
-                }
-                if (time_delta_layer) {
-                    text_layer_set_text(time_delta_layer, time_delta_str);
                 }
+                displayAgeText(t_delta);
                 break;
             case CGM_BGS:
                 ;
-                ProcessingState* state = data_processor_create(new_tuple->value->cstring, ',');
-                uint8_t num_strings = data_processor_count(state);
-                //APP_LOG(APP_LOG_LEVEL_DEBUG, "BG num: %i", num_strings);
-                bgs = (int*) malloc((num_strings - 1) * sizeof(int));
-                for (uint8_t n = 0; n < num_strings; n += 1) {
-                    if (n == 0) {
-                        is_web = data_processor_get_int(state);
-                        //APP_LOG(APP_LOG_LEVEL_DEBUG, "Tag Raw : %i", tag_raw);
-                    }
-                    else {
-                        bgs[n - 1] = data_processor_get_int(state);
-                        //APP_LOG(APP_LOG_LEVEL_DEBUG, "BG Split: %i", bgs[n-1]);
-                    }
-                }
-                num_bgs = num_strings - 1;
-                break;
-            case CGM_BG_TIMES:
-                ;
-                ProcessingState* state_t = data_processor_create(new_tuple->value->cstring, ',');
-                uint8_t num_strings_t = data_processor_count(state_t);
-                //APP_LOG(APP_LOG_LEVEL_DEBUG, "BG_t num: %i", num_strings_t);
-                bg_times = (int*) malloc(num_strings_t * sizeof(int));
-                for (uint8_t n = 0; n < num_strings_t; n += 1) {
-                    bg_times[n] = data_processor_get_int(state_t);
-                    //APP_LOG(APP_LOG_LEVEL_DEBUG, "BG_t Split: %i", bg_times[n]);
+                BgPacket packet;
+                if (bg_packet_parse(&packet, new_tuple)) {
+                    rebuild_chart = bg_chart_apply_packet(chart_layer, &packet);
+                    has_history_update = true;
+                } else {
+                    // unknown packet version; drop what we hold so the next request asks for a full resync
+                    bg_history_clear();
+                    rebuild_chart = true;
                 }
                 break;
         }
@@ -665,19 +1014,26 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
         time_t t = time(NULL);
         struct tm * time_now = localtime(&t);
         clock_refresh(time_now);
-        layer_mark_dirty(s_canvas_layer);
-        if (chart_layer) {
-            chart_layer_set_canvas_color(chart_layer, GColorBlack);
-            chart_layer_set_margin(chart_layer, 7);
-            chart_layer_set_data(chart_layer, bg_times, eINT, bgs, eINT, num_bgs);
+        if (rebuild_chart) {
+            bg_chart_refresh(chart_layer);
         }
     }
     //Process Alerts
-    process_alert();
+    process_alert(true);
     // accel_tap_service_unsubscribe();
     has_launched = 1;
 
-    //timer2 = app_timer_register(60000*2, timer_callback_2, NULL);
+    // Only replies carrying readings are worth showing again at the next launch; error replies are not
+    if (has_history_update) {
+        bg_store_save(&last_state);
+    }
+
+    fetch_scheduler_on_reply(history_newest());
+
+    CGM_PERF_SAMPLE_HEAP();
+#if CGM_PERF
+    update_perf_overlay();
+#endif
 
 }
 
@@ -685,17 +1041,21 @@ static void inbox_dropped_callback(AppMessageResult reason, void *context) {
     s_color_channels[0] = 0;
     s_color_channels[1] = 0;
     s_color_channels[2] = 255;
+    if (s_alert_layer) {
+        layer_mark_dirty(s_alert_layer);
+    }
 
     safe_text_layer_set_text_color(time_delta_layer, GColorBlack);
-    safe_bitmap_layer_set_compositing_mode(icon_layer, GCompOpClear);
-    safe_text_layer_set_text_color(bg_layer, GColorBlack);
+    set_icon_ink(GColorBlack);
+    set_bg_ink(GColorBlack);
     safe_text_layer_set_text_color(delta_layer, GColorBlack);
 
     snprintf(time_delta_str, 12, "in-err(%d)", t_delta);
-    safe_text_layer_set_text(bg_layer, translate_error(reason));
+    set_bg_text(translate_error(reason));
     safe_text_layer_set_text(time_delta_layer, time_delta_str);
 
-    comm_alert();
+    comm_alert(fetch_scheduler_failures());
+    fetch_scheduler_on_failure();
 
 }
 
@@ -703,18 +1063,22 @@ static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResul
     s_color_channels[0] = 0;
     s_color_channels[1] = 0;
     s_color_channels[2] = 255;
+    if (s_alert_layer) {
+        layer_mark_dirty(s_alert_layer);
+    }
 
     safe_text_layer_set_text_color(time_delta_layer, GColorBlack);
-    safe_bitmap_layer_set_compositing_mode(icon_layer, GCompOpClear);
-    safe_text_layer_set_text_color(bg_layer, GColorBlack);
+    set_icon_ink(GColorBlack);
+    set_bg_ink(GColorBlack);
     safe_text_layer_set_text_color(delta_layer, GColorBlack);
 
     snprintf(time_delta_str, 12, "out-err(%d)", t_delta);
 
-    safe_text_layer_set_text(bg_layer, translate_error(reason));
+    set_bg_text(translate_error(reason));
 
     safe_text_layer_set_text(time_delta_layer, time_delta_str);
-    comm_alert();
+    comm_alert(fetch_scheduler_failures());
+    fetch_scheduler_on_failure();
 
 }
 
@@ -722,6 +1086,29 @@ static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
     //APP_LOG(APP_LOG_LEVEL_INFO, "out sent callback");
 }
 
+/**
+ * Paints the last state saved by bg_store, so the face shows the last known reading and chart straight away while
+ * the phone is asked for fresh data in the background.
+ */
+static void restore_last_state() {
+    if (!has_stored_state || bg_history_count() == 0) {
+        has_stored_state = false;
+        return;
+    }
+
+    set_bg_text(last_state.egv);
+    safe_text_layer_set_text(delta_layer, last_state.delta);
+    set_trend_icon(last_state.trend);
+    alert_state = last_state.alert;
+    process_alert(false);
+
+    t_delta = history_age_minutes();
+    displayAgeText(t_delta);
+
+    bg_chart_refresh(chart_layer);
+    has_launched = 1;
+}
+
 /**
  * This method handles the actual layout of the main screen.
  */
@@ -742,9 +1129,29 @@ static void window_load(Window * window) {
     layer_set_update_proc(s_canvas_layer, update_proc);
     layer_add_child(window_layer, s_canvas_layer);
 
+#ifdef PBL_PLATFORM_CHALK
+    create_band_paths();
+    s_alert_layer = layer_create(window_bounds);
+    s_clock_band_layer = layer_create(GRect(0, 0, 180, 42));
+#else
+    s_alert_layer = layer_create(GRect(0, 22, 144, 78));
+    s_clock_band_layer = layer_create(GRect(0, 0, 144, 25));
+#endif
+    layer_set_update_proc(s_alert_layer, alert_update_proc);
+    layer_set_update_proc(s_clock_band_layer, clock_band_update_proc);
+#ifdef PBL_PLATFORM_CHALK
+    // the top band overlaps the alert box
+    layer_add_child(s_canvas_layer, s_alert_layer);
+    layer_add_child(s_canvas_layer, s_clock_band_layer);
+#else
+    // the edge of the alert box overlays the wall clock band
+    layer_add_child(s_canvas_layer, s_clock_band_layer);
+    layer_add_child(s_canvas_layer, s_alert_layer);
+#endif
+
 #ifdef PBL_PLATFORM_CHALK   
-    icon_layer = bitmap_layer_create(GRect(106 + 18, 41+offset, 30, 30));
-    bg_layer = text_layer_create(GRect(4 + 18, 25+offset, 95, 75));
+    GRect icon_frame = GRect(106 + 18, 41+offset, TREND_ICON_SIZE, TREND_ICON_SIZE);
+    bg_layer = layer_create(GRect(4 + 18, 25+offset, 95, 75));
     delta_layer = text_layer_create(GRect(0, 18, 180, 25));
     time_delta_layer = text_layer_create(GRect(0, 0, 180, 25));
     time_layer = text_layer_create(GRect(40, 137, 100, 40));
@@ -757,8 +1164,8 @@ static void window_load(Window * window) {
     // placement of text layers
     #if LAYOUT_COSTIK
     /** Costik's settings **/
-    icon_layer = bitmap_layer_create(GRect(106, 34 + offset, 30, 30));
-    bg_layer = text_layer_create(GRect(8, 17 + offset, 100, 75));
+    GRect icon_frame = GRect(106, 34 + offset, TREND_ICON_SIZE, TREND_ICON_SIZE);
+    bg_layer = layer_create(GRect(8, 17 + offset, 100, 75));
     delta_layer = text_layer_create(GRect(4, 74, 136, 25));
     time_delta_layer = text_layer_create(GRect(4, 21, 136, 25));
     time_layer = text_layer_create(GRect(0, 2, 144, 25));
@@ -769,8 +1176,8 @@ static void window_load(Window * window) {
     text_layer_set_text_alignment(delta_layer, GTextAlignmentRight);
     #else
     /** Conroy's settings **/
-    icon_layer = bitmap_layer_create(GRect(106, 34 + offset, 30, 30));
-    bg_layer = text_layer_create(GRect(8, 17 + offset, 100, 75));
+    GRect icon_frame = GRect(106, 34 + offset, TREND_ICON_SIZE, TREND_ICON_SIZE);
+    bg_layer = layer_create(GRect(8, 17 + offset, 100, 75));
 
     time_delta_layer = text_layer_create(GRect(6, 74, 66, 25));
     delta_layer = text_layer_create(GRect(72, 74, 68, 25));
@@ -782,15 +1189,24 @@ static void window_load(Window * window) {
     text_layer_set_text_alignment(delta_layer, GTextAlignmentRight);
     #endif
 #endif  
+    load_trend_icons();
+    load_fonts();
+    bg_glyphs_load();
+    update_bg_font(bg_text);
+#if TREND_ICONS_PDC
+    icon_layer = layer_create(icon_frame);
+    layer_set_update_proc(icon_layer, icon_update_proc);
+    layer_add_child(s_canvas_layer, icon_layer);
+#else
+    icon_layer = bitmap_layer_create(icon_frame);
     bitmap_layer_set_background_color(icon_layer, GColorClear);
-    safe_bitmap_layer_set_compositing_mode(icon_layer, GCompOpClear);
     layer_add_child(s_canvas_layer, bitmap_layer_get_layer(icon_layer));
+#endif
+    set_icon_ink(GColorBlack);
 
-    safe_text_layer_set_text_color(bg_layer, GColorBlack);
-    text_layer_set_background_color(bg_layer, GColorClear);
-    text_layer_set_font(bg_layer, fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_HN_BOLD_48)));
-    text_layer_set_text_alignment(bg_layer, GTextAlignmentCenter);
-    layer_add_child(s_canvas_layer, text_layer_get_layer(bg_layer));
+    set_bg_ink(GColorBlack);
+    layer_set_update_proc(bg_layer, bg_update_proc);
+    layer_add_child(s_canvas_layer, bg_layer);
 
     safe_text_layer_set_text_color(delta_layer, GColorBlack);
     text_layer_set_background_color(delta_layer, GColorClear);
@@ -809,26 +1225,66 @@ static void window_load(Window * window) {
 
 #ifdef PBL_PLATFORM_CHALK   
     //text_layer_set_font(time_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-    text_layer_set_font(time_layer, fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_LATO_BOLD_18)));
+    text_layer_set_font(time_layer, time_font);
 #else 
     //text_layer_set_font(time_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
-    text_layer_set_font(time_layer, fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_LATO_BOLD_18)));
+    text_layer_set_font(time_layer, time_font);
 #endif
 
     text_layer_set_text_alignment(time_layer, GTextAlignmentCenter);
     layer_add_child(s_canvas_layer, text_layer_get_layer(time_layer));
 
     chart_layer_set_plot_color(chart_layer, GColorWhite);
-    chart_layer_set_canvas_color(chart_layer, GColorClear);
+    chart_layer_set_canvas_color(chart_layer, GColorFromRGB(b_color_channels[0], b_color_channels[1], b_color_channels[2]));
     chart_layer_show_points_on_line(chart_layer, true);
     chart_layer_animate(chart_layer, false);
+    chart_layer_set_margin(chart_layer, 7);
+    chart_layer_set_x_window(chart_layer, BG_CHART_WINDOW_MINUTES);
     // chart_layer_set_plot_type(chart_layer, eLINE)
     layer_add_child(window_layer, chart_layer_get_layer(chart_layer));
 
+#if CGM_PERF
+    // the debug overlay covers the bottom of the face, over the chart, and stays hidden until the watch is tapped
+    perf_layer = text_layer_create(GRect(0, window_bounds.size.h - 66, window_bounds.size.w, 66));
+    text_layer_set_text_alignment(perf_layer, GTextAlignmentCenter);
+    text_layer_set_background_color(perf_layer, GColorBlack);
+    text_layer_set_text_color(perf_layer, GColorWhite);
+    text_layer_set_font(perf_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+    layer_set_hidden(text_layer_get_layer(perf_layer), true);
+    layer_add_child(window_layer, text_layer_get_layer(perf_layer));
+#endif
+
+    restore_last_state();
 }
 
 static void window_unload(Window * window) {
+    // the icon layer draws from the trend icons, so it goes before them
+#if TREND_ICONS_PDC
+    layer_destroy(icon_layer);
+#else
+    bitmap_layer_destroy(icon_layer);
+#endif
+    icon_layer = NULL;
+    unload_trend_icons();
+    // the text layers hold on to the custom fonts, so they go first
+    layer_destroy(bg_layer);
+    bg_layer = NULL;
+    text_layer_destroy(delta_layer);
+    text_layer_destroy(time_delta_layer);
+    text_layer_destroy(time_layer);
+    delta_layer = time_delta_layer = time_layer = NULL;
+#if CGM_PERF
+    text_layer_destroy(perf_layer);
+    perf_layer = NULL;
+#endif
+    unload_fonts();
+    bg_glyphs_unload();
+    layer_destroy(s_clock_band_layer);
+    layer_destroy(s_alert_layer);
     layer_destroy(s_canvas_layer);
+#ifdef PBL_PLATFORM_CHALK
+    destroy_band_paths();
+#endif
 }
 
 /*********************************** App **************************************/
@@ -838,23 +1294,25 @@ static void init() {
 
     if (launch_reason() == APP_LAUNCH_TIMELINE_ACTION) {
         uint32_t arg = launch_get_args();
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Launch: %i", (int )arg);
+        CGM_LOG_DEBUG(APP, "Launch: %i", (int )arg);
         if (arg == 2) {
             alert_snooze = 0;
-            APP_LOG(APP_LOG_LEVEL_DEBUG, "cancel mute");
+            CGM_LOG_DEBUG(APP, "cancel mute");
 
         } else if (arg > 2) {
             alert_snooze = t + arg * 60;
         }
         persist_write_int(SNOOZE_KEY, alert_snooze);
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "mute for: %i", (int )alert_snooze);
+        CGM_LOG_DEBUG(APP, "mute for: %i", (int )alert_snooze);
     }
 
     if (persist_exists(SNOOZE_KEY)) {
         alert_snooze = persist_read_int(SNOOZE_KEY);
     }
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "Snooze Exp: %i", (int )alert_snooze);
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "time: %i", (int )t);
+    has_stored_state = bg_store_load(&last_state);
+
+    CGM_LOG_DEBUG(ALERT, "Snooze Exp: %i", (int )alert_snooze);
+    CGM_LOG_DEBUG(APP, "time: %i", (int )t);
     struct tm * time_now = localtime(&t);
     tick_handler(time_now, MINUTE_UNIT);
 
@@ -869,6 +1327,9 @@ static void init() {
 
     // accel_service_set_sampling_rate(ACCEL_SAMPLING_10HZ);
     // accel_tap_service_subscribe(accel_tap_handler);
+#if CGM_PERF
+    accel_tap_service_subscribe(perf_tap_handler);
+#endif
 
     // Registering callbacks
     app_message_register_inbox_received(inbox_received_callback);
@@ -877,11 +1338,14 @@ static void init() {
     app_message_register_outbox_sent(outbox_sent_callback);
     app_message_open(app_message_inbox_size_maximum(), 40);
 
-    timer = app_timer_register(1000, timer_callback, NULL);
+    // Message SHOULD come from smartphone app, but this will kick it off in a second if it can.
+    fetch_scheduler_init(fetch_data);
+    fetch_scheduler_fetch_soon(1);
 
 }
 
 static void deinit() {
+    fetch_scheduler_deinit();
     window_destroy(s_main_window);
 }
 
@@ -1,17 +1,31 @@
 #include "pebble_chart.h"
+#include "cgm_log.h"
+#include "cgm_perf.h"
 
 #define NOT_SET -777 // magic number to represent not value not set
 
 typedef struct {
   // original data
+  // integer data (eINT on both axes) is kept as int32_t and laid out in
+  // fixed-point, anything else is kept and laid out as float
+  bool bFixedPoint;
   float* pXOrigData;
   float* pYOrigData;
+  int32_t* pXOrigInt;
+  int32_t* pYOrigInt;
   unsigned int iNumOrigPoints;
+  bool bSorted; // x-values never decrease
 
   // cached data
+  // integer data is appended to in place: the original and cached points
+  // both start at iStart in buffers of iCapacity, and cached x-values are
+  // relative to the layout's origin, moved by iXShift when drawing
   int* pXData;
   int* pYData;
   unsigned int iNumPoints;
+  unsigned int iStart;
+  unsigned int iCapacity;
+  int iXShift;
   int iXAxisIntercept;
   int iYAxisIntercept;
   int iYTicks;
@@ -27,22 +41,44 @@ typedef struct {
   float fXMax;
   float fYMin;
   float fYMax;
-  float fXYRange;
+  int32_t iXMin; // integer copies of the above for the fixed-point layout
+  int32_t iXMax;
+  int32_t iYMin;
+  int32_t iYMax;
+  int iXYRange;
+  int32_t iXWindow;
   bool bShowFrame;
   bool bAnimate;
   uint32_t iAnimationDuration;
 
   // state
   bool bLayoutDirty;
+  bool bIncremental; // layout can be extended by chart_layer_append_point
+  int32_t iDataMinY; // raw y extremes of the integer data
+  int32_t iDataMaxY;
+  int32_t iLayoutMinY; // y-range of the integer layout
+  int32_t iLayoutMaxY;
+  int32_t iYScale; // Q16.16 scales of the integer layout
+  int32_t iXScale;
+  int32_t iXAnchor; // x-value laid out at pixel 0 before shifting
+  GBitmap* pCache; // the chart as last drawn, in full frame buffer rows
+  bool bCacheDirty;
   Animation* pAnimation;
   AnimationImplementation* pAnimationImpl;
   unsigned int iPointsToDraw;
 } ChartLayerData;
 
+// Q16.16 fixed-point helpers for the integer layout path
+#define FIXED_SHIFT 16
+#define FIXED_ONE (1 << FIXED_SHIFT)
+
 // function prototypes
 static int closest_log10(float);
 static float exponential10(int);
+static int32_t floor_power10(int32_t);
+static bool chart_reserve_int(ChartLayerData*, unsigned int);
 static void chart_layer_update_func(Layer*, GContext*);
+static void chart_layer_invalidate(ChartLayer* layer);
 static void chart_layer_update_layout(ChartLayer* layer);
 static void animation_started(Animation*, void*);
 static void animation_stopped(Animation*, bool, void*);
@@ -58,6 +94,12 @@ Layer* chart_layer_get_layer(ChartLayer* layer) {
   return (Layer*)layer;
 }
 
+// drops the cached drawing and schedules a redraw
+static void chart_layer_invalidate(ChartLayer* layer) {
+  get_chart_data(layer)->bCacheDirty = true;
+  layer_mark_dirty(chart_layer_get_layer(layer));
+}
+
 // creator
 ChartLayer* chart_layer_create(GRect frame) {
   // create "root" Layer
@@ -67,13 +109,23 @@ ChartLayer* chart_layer_create(GRect frame) {
 
   // set defaults
   ChartLayerData* data = get_chart_data(layer);
+  data->bFixedPoint = false;
   data->pXOrigData = NULL;
   data->pYOrigData = NULL;
+  data->pXOrigInt = NULL;
+  data->pYOrigInt = NULL;
   data->iNumOrigPoints = 0;
+  data->bSorted = true;
   data->pXData = NULL;
   data->pYData = NULL;
   data->iNumPoints = 0;
+  data->iStart = 0;
+  data->iCapacity = 0;
+  data->iXShift = 0;
   data->bLayoutDirty = false;
+  data->bIncremental = false;
+  data->pCache = NULL;
+  data->bCacheDirty = true;
   data->typePlot = eLINE;
   data->clrPlot = GColorWhite;
   data->clrCanvas = GColorBlack;
@@ -83,7 +135,12 @@ ChartLayer* chart_layer_create(GRect frame) {
   data->fXMax = NOT_SET;
   data->fYMin = NOT_SET;
   data->fYMax = NOT_SET;
-  data->fXYRange = 30.0;
+  data->iXMin = NOT_SET;
+  data->iXMax = NOT_SET;
+  data->iYMin = NOT_SET;
+  data->iYMax = NOT_SET;
+  data->iXYRange = 30;
+  data->iXWindow = 0;
   data->bShowFrame = false;
   data->bAnimate = true;
   data->iAnimationDuration = 1500;
@@ -117,10 +174,14 @@ void chart_layer_destroy(ChartLayer* layer) {
     ChartLayerData* pData = get_chart_data(layer);
     free(pData->pXOrigData);
     free(pData->pYOrigData);
+    free(pData->pXOrigInt);
+    free(pData->pYOrigInt);
     free(pData->pXData);
     free(pData->pYData);
     animation_destroy(pData->pAnimation);
     free(pData->pAnimationImpl);
+    if (pData->pCache)
+      gbitmap_destroy(pData->pCache);
 
     // destroy "root" Layer
     layer_destroy(chart_layer_get_layer(layer));
@@ -136,25 +197,29 @@ void chart_layer_set_plot_type(ChartLayer* layer, const ChartPlotType type) {
     pData->typePlot = type;
     pData->bLayoutDirty = true;
 
-    layer_mark_dirty(chart_layer_get_layer(layer));
+    chart_layer_invalidate(layer);
   }
 }
 
 void chart_layer_set_plot_color(ChartLayer* layer, GColor color) {
   if (layer) {
     ChartLayerData* pData = get_chart_data(layer);
+    if (gcolor_equal(pData->clrPlot, color))
+      return;
     pData->clrPlot = color;
 
-    layer_mark_dirty(chart_layer_get_layer(layer));
+    chart_layer_invalidate(layer);
   }
 }
 
 void chart_layer_set_canvas_color(ChartLayer* layer, GColor color) {
   if (layer) {
     ChartLayerData* pData = get_chart_data(layer);
+    if (gcolor_equal(pData->clrCanvas, color))
+      return;
     pData->clrCanvas = color;
 
-    layer_mark_dirty(chart_layer_get_layer(layer));
+    chart_layer_invalidate(layer);
   }
 }
 
@@ -163,7 +228,7 @@ void chart_layer_show_points_on_line(ChartLayer* layer, bool bShow) {
     ChartLayerData* pData = get_chart_data(layer);
     pData->bShowPoints = bShow;
 
-    layer_mark_dirty(chart_layer_get_layer(layer));
+    chart_layer_invalidate(layer);
   }
 }
 
@@ -176,7 +241,7 @@ void chart_layer_set_margin(ChartLayer* layer, int margin) {
       ++pData->iMargin;
     pData->bLayoutDirty = true;
 
-    layer_mark_dirty(chart_layer_get_layer(layer));
+    chart_layer_invalidate(layer);
   }
 }
 
@@ -184,9 +249,10 @@ void chart_layer_set_xmin(ChartLayer* layer, float xmin) {
   if (layer) {
     ChartLayerData* pData = get_chart_data(layer);
     pData->fXMin = xmin;
+    pData->iXMin = (int32_t)xmin;
     pData->bLayoutDirty = true;
 
-    layer_mark_dirty(chart_layer_get_layer(layer));
+    chart_layer_invalidate(layer);
   }
 }
 
@@ -198,9 +264,10 @@ void chart_layer_set_xmax(ChartLayer* layer, float xmax) {
   if (layer) {
     ChartLayerData* pData = get_chart_data(layer);
     pData->fXMax = xmax;
+    pData->iXMax = (int32_t)xmax;
     pData->bLayoutDirty = true;
 
-    layer_mark_dirty(chart_layer_get_layer(layer));
+    chart_layer_invalidate(layer);
   }
 }
 
@@ -212,9 +279,10 @@ void chart_layer_set_ymin(ChartLayer* layer, float ymin) {
   if (layer) {
     ChartLayerData* pData = get_chart_data(layer);
     pData->fYMin = ymin;
+    pData->iYMin = (int32_t)ymin;
     pData->bLayoutDirty = true;
 
-    layer_mark_dirty(chart_layer_get_layer(layer));
+    chart_layer_invalidate(layer);
   }
 }
 
@@ -226,9 +294,10 @@ void chart_layer_set_ymax(ChartLayer* layer, float ymax) {
   if (layer) {
     ChartLayerData* pData = get_chart_data(layer);
     pData->fYMax = ymax;
+    pData->iYMax = (int32_t)ymax;
     pData->bLayoutDirty = true;
 
-    layer_mark_dirty(chart_layer_get_layer(layer));
+    chart_layer_invalidate(layer);
   }
 }
 
@@ -246,7 +315,7 @@ void chart_layer_show_frame(ChartLayer* layer, bool bShow) {
       else
 	++pData->iMargin;
 
-      layer_mark_dirty(chart_layer_get_layer(layer));
+      chart_layer_invalidate(layer);
     }
   }
 }
@@ -265,6 +334,16 @@ void chart_layer_set_animation_duration(ChartLayer* layer, const uint32_t ms) {
   }
 }
 
+void chart_layer_set_x_window(ChartLayer* layer, const int window) {
+  if (layer) {
+    ChartLayerData* pData = get_chart_data(layer);
+    pData->iXWindow = window;
+    pData->bLayoutDirty = true;
+
+    chart_layer_invalidate(layer);
+  }
+}
+
 ////////////////////////////////////
 
 // sets data into chart
@@ -278,37 +357,69 @@ void chart_layer_set_data(ChartLayer* layer,
     
     ChartLayerData* pData = get_chart_data(layer);
 
-    // clean up previous data
-    if (pData->iNumOrigPoints) {
-      free(pData->pXOrigData);
-      free(pData->pYOrigData);
-    }
-    
-    // make space to copy data
-    pData->iNumOrigPoints = iNumPoints;
-    pData->pXOrigData = (float*) malloc(pData->iNumOrigPoints * sizeof(float));
-    pData->pYOrigData = (float*) malloc(pData->iNumOrigPoints * sizeof(float));
-
-    if (typeX == eINT) {
-      // cast
-      for (unsigned int i = 0; i < iNumPoints; ++i)
-	pData->pXOrigData[i] = (float)(((int*)pX)[i]);
+    const bool bFixedPoint = (typeX == eINT) && (typeY == eINT);
+
+    // clean up previous data, integer buffers are kept for reuse
+    free(pData->pXOrigData);
+    free(pData->pYOrigData);
+    pData->pXOrigData = NULL;
+    pData->pYOrigData = NULL;
+    if (!bFixedPoint || pData->bFixedPoint != bFixedPoint) {
+      free(pData->pXOrigInt);
+      free(pData->pYOrigInt);
+      free(pData->pXData);
+      free(pData->pYData);
+      pData->pXOrigInt = NULL;
+      pData->pYOrigInt = NULL;
+      pData->pXData = NULL;
+      pData->pYData = NULL;
+      pData->iCapacity = 0;
     }
-    else if (typeX == eFLOAT) {
-      memcpy(pData->pXOrigData, pX, iNumPoints * sizeof(float));
+    pData->iNumOrigPoints = 0;
+    pData->iNumPoints = 0;
+    pData->iStart = 0;
+    pData->bFixedPoint = bFixedPoint;
+    pData->bSorted = true;
+
+    if (pData->bFixedPoint) {
+      // integer data stays integer, there is no FPU to spend float math on
+      if (chart_reserve_int(pData, iNumPoints)) {
+	pData->iNumOrigPoints = iNumPoints;
+	for (unsigned int i = 0; i < iNumPoints; ++i) {
+	  pData->pXOrigInt[i] = ((int*)pX)[i];
+	  pData->pYOrigInt[i] = ((int*)pY)[i];
+	  if ((i != 0) && (pData->pXOrigInt[i] < pData->pXOrigInt[i-1]))
+	    pData->bSorted = false;
+	}
+      }
     }
+    else {
+      // make space to copy data
+      pData->iNumOrigPoints = iNumPoints;
+      pData->pXOrigData = (float*) malloc(pData->iNumOrigPoints * sizeof(float));
+      pData->pYOrigData = (float*) malloc(pData->iNumOrigPoints * sizeof(float));
+
+      if (typeX == eINT) {
+	// cast
+	for (unsigned int i = 0; i < iNumPoints; ++i)
+	  pData->pXOrigData[i] = (float)(((int*)pX)[i]);
+      }
+      else if (typeX == eFLOAT) {
+	memcpy(pData->pXOrigData, pX, iNumPoints * sizeof(float));
+      }
 
-    if (typeY == eINT) {
-      // cast
-      for (unsigned int i = 0; i < iNumPoints; ++i)
-	pData->pYOrigData[i] = (float)(((int*)pY)[i]);
-    }
-    else if (typeY == eFLOAT) {
-      memcpy(pData->pYOrigData, pY, iNumPoints * sizeof(float));
+      if (typeY == eINT) {
+	// cast
+	for (unsigned int i = 0; i < iNumPoints; ++i)
+	  pData->pYOrigData[i] = (float)(((int*)pY)[i]);
+      }
+      else if (typeY == eFLOAT) {
+	memcpy(pData->pYOrigData, pY, iNumPoints * sizeof(float));
+      }
     }
 
     pData->bLayoutDirty = true;
-    layer_mark_dirty(chart_layer_get_layer(layer));
+    chart_layer_invalidate(layer);
   }
 }
 
@@ -323,9 +434,332 @@ static int cmpChartSortHelper(const void* a, const void* b) {
   return ((const ChartSortHelper*)a)->x_value - ((const ChartSortHelper*)b)->x_value;
 }
 
+// integer twin of ChartSortHelper for the fixed-point layout
+typedef struct {
+  int32_t x_value;
+  int index;
+} ChartSortHelperInt;
+
+static int cmpChartSortHelperInt(const void* a, const void* b) {
+  const int32_t iA = ((const ChartSortHelperInt*)a)->x_value;
+  const int32_t iB = ((const ChartSortHelperInt*)b)->x_value;
+  return (iA > iB) - (iA < iB);
+}
+
+// makes room for iCount integer points from iStart on, sliding the window
+// back to the front of the buffers before growing them
+// the original and cached buffers share iStart and iCapacity
+static bool chart_reserve_int(ChartLayerData* pData, unsigned int iCount) {
+  if (pData->iStart + iCount <= pData->iCapacity)
+    return true;
+
+  if (pData->iStart) {
+    memmove(pData->pXOrigInt, pData->pXOrigInt + pData->iStart, pData->iNumOrigPoints * sizeof(int32_t));
+    memmove(pData->pYOrigInt, pData->pYOrigInt + pData->iStart, pData->iNumOrigPoints * sizeof(int32_t));
+    memmove(pData->pXData, pData->pXData + pData->iStart, pData->iNumPoints * sizeof(int));
+    memmove(pData->pYData, pData->pYData + pData->iStart, pData->iNumPoints * sizeof(int));
+    pData->iStart = 0;
+    if (iCount <= pData->iCapacity)
+      return true;
+  }
+
+  unsigned int iCapacity = pData->iCapacity ? pData->iCapacity : 16;
+  while (iCapacity < iCount)
+    iCapacity *= 2;
+
+  int32_t* pXOrig = (int32_t*) realloc(pData->pXOrigInt, iCapacity * sizeof(int32_t));
+  if (pXOrig)
+    pData->pXOrigInt = pXOrig;
+  int32_t* pYOrig = (int32_t*) realloc(pData->pYOrigInt, iCapacity * sizeof(int32_t));
+  if (pYOrig)
+    pData->pYOrigInt = pYOrig;
+  int* pX = (int*) realloc(pData->pXData, iCapacity * sizeof(int));
+  if (pX)
+    pData->pXData = pX;
+  int* pY = (int*) realloc(pData->pYData, iCapacity * sizeof(int));
+  if (pY)
+    pData->pYData = pY;
+  if (!pXOrig || !pYOrig || !pX || !pY)
+    return false;
+
+  pData->iCapacity = iCapacity;
+  return true;
+}
+
+// applies the limits and the minimum range to the raw y extremes
+static void chart_fixed_y_range(ChartLayerData* pData, int32_t* pMinY, int32_t* pMaxY) {
+  int32_t iMinY = (pData->iYMin != NOT_SET) ? pData->iYMin : pData->iDataMinY;
+  int32_t iMaxY = (pData->iYMax != NOT_SET) ? pData->iYMax : pData->iDataMaxY;
+
+  int32_t iXYRange = iMaxY - iMinY;
+  if (iXYRange < 30) {
+    int32_t diff = 30 - iXYRange;
+    iMaxY += diff;
+    iMinY -= diff;
+
+    if (iMinY < 40)
+      iMinY = 40;
+    if (iMaxY > 400)
+      iMaxY = 400;
+
+    iXYRange = 30;
+  }
+  pData->iXYRange = iXYRange;
+
+  *pMinY = iMinY;
+  *pMaxY = iMaxY;
+}
+
+// pixel row of an integer y value
+// rounded, as the scale is rounded down and the top of the range has to
+// land on the top margin rather than a pixel under it
+static int chart_fixed_y_pixel(ChartLayerData* pData, int iHeight, int32_t y) {
+  const int64_t iOffset = (int64_t)(y - pData->iLayoutMinY) * pData->iYScale;
+  return iHeight - ((int)((iOffset + (FIXED_ONE / 2)) >> FIXED_SHIFT) + pData->iMargin);
+}
+
+// y scale, axis and ticks for the current iLayoutMinY / iLayoutMaxY
+static void chart_fixed_y_scale(ChartLayerData* pData, int iHeight) {
+  const int32_t iYSpan = (pData->iLayoutMaxY > pData->iLayoutMinY) ? (pData->iLayoutMaxY - pData->iLayoutMinY) : 1;
+  pData->iYScale = ((int32_t)(iHeight - (2 * pData->iMargin)) << FIXED_SHIFT) / iYSpan;
+
+  // x-axis position
+  pData->iYAxisIntercept = chart_fixed_y_pixel(pData, iHeight, 0);
+
+  // calc y tick spacing
+  pData->iYTicks = (int)(((int64_t)pData->iYScale * floor_power10(iYSpan)) >> FIXED_SHIFT);
+}
+
+// fixed-point version of the layout below, used for eINT data
+// scales are Q16.16 and products are taken in 64 bits, so there is no
+// float (soft-float on the watch) anywhere in the path
+static void chart_layer_update_layout_fixed(ChartLayer* layer) {
+  ChartLayerData* pData = get_chart_data(layer);
+  pData->bIncremental = false;
+  if (!pData->iNumOrigPoints)
+    return;
+
+  const int32_t* pXOrig = pData->pXOrigInt + pData->iStart;
+  const int32_t* pYOrig = pData->pYOrigInt + pData->iStart;
+  int* pXData = pData->pXData + pData->iStart;
+  int* pYData = pData->pYData + pData->iStart;
+
+  // figure out sort order, time-ordered data is already in order
+  ChartSortHelperInt* sort_order = NULL;
+  if (!pData->bSorted && (pData->typePlot != eSCATTER)) {
+    sort_order = (ChartSortHelperInt*) malloc(pData->iNumOrigPoints * sizeof(ChartSortHelperInt));
+    for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i)
+      sort_order[i] = ((ChartSortHelperInt) { .x_value = pXOrig[i], .index = i });
+    qsort(sort_order, pData->iNumOrigPoints, sizeof(ChartSortHelperInt), &cmpChartSortHelperInt);
+  }
+#define SORTED(i) (sort_order ? (unsigned int)sort_order[i].index : (i))
+
+  // more points than pixel columns are decimated below
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  const unsigned int iColumns = (unsigned int)bounds.size.w - (2 * pData->iMargin);
+  const bool bDecimate = (pData->typePlot != eSCATTER) && (iColumns <= pData->iNumOrigPoints);
+
+  // figure out Y-scale over all points, so decimation can't hide an excursion
+  pData->iDataMaxY = pYOrig[0];
+  pData->iDataMinY = pYOrig[0];
+  for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i) {
+    if (pYOrig[i] > pData->iDataMaxY)
+      pData->iDataMaxY = pYOrig[i];
+    if (pYOrig[i] < pData->iDataMinY)
+      pData->iDataMinY = pYOrig[i];
+  }
+  chart_fixed_y_range(pData, &pData->iLayoutMinY, &pData->iLayoutMaxY);
+  chart_fixed_y_scale(pData, bounds.size.h);
+
+  // figure out X-scale
+  int32_t iMaxX = pXOrig[0];
+  int32_t iMinX = pXOrig[0];
+  int32_t iMinXSep = (pData->iNumOrigPoints > 1) ? pXOrig[SORTED(1)] - pXOrig[SORTED(0)] : 0;
+  for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i) {
+    if (pXOrig[i] > iMaxX)
+      iMaxX = pXOrig[i];
+    if (pXOrig[i] < iMinX)
+      iMinX = pXOrig[i];
+    if (i != 0) {
+      if ((pXOrig[SORTED(i)] - pXOrig[SORTED(i-1)]) < iMinXSep)
+	iMinXSep = pXOrig[SORTED(i)] - pXOrig[SORTED(i-1)];
+    }
+  }
+  if (pData->iXWindow > 0)
+    iMinX = iMaxX - pData->iXWindow + 1;
+  if (pData->iXMin != NOT_SET)
+    iMinX = pData->iXMin;
+  if (pData->iXMax != NOT_SET)
+    iMaxX = pData->iXMax;
+  if (pData->typePlot != eBAR)
+    iMinXSep = 0;
+  const int32_t iXSpan = (iMaxX - iMinX + iMinXSep > 0) ? (iMaxX - iMinX + iMinXSep) : 1;
+  pData->iXScale = ((int32_t)(bounds.size.w - (2 * pData->iMargin)) << FIXED_SHIFT) / iXSpan;
+
+  // calc x values relative to the anchor, offset by half a bar;
+  // doubled so the half stays exact. the shift to the left edge and the
+  // margin are added when drawing. a sliding window is anchored at 0, the
+  // same as chart_layer_append_layout goes on using, so appending a point
+  // lays out every point exactly where a full layout would
+  pData->iXAnchor = ((pData->iXWindow > 0) && (pData->typePlot != eBAR)) ? 0 : iMinX;
+  pData->iXShift = pData->iMargin - (int)(((int64_t)(iMinX - pData->iXAnchor) * pData->iXScale) >> FIXED_SHIFT);
+  for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i) {
+    const int64_t iOffset = (2 * (int64_t)(pXOrig[SORTED(i)] - pData->iXAnchor) + iMinXSep) * pData->iXScale;
+    pXData[i] = (int)(iOffset >> (FIXED_SHIFT + 1));
+  }
+
+  // calc y values, decimating to the lowest and highest point of each
+  // pixel column (in x order) so spikes and lows survive
+  // points are only ever moved towards the front, so this works in place
+  unsigned int j = 0;
+  for (unsigned int i = 0; i < pData->iNumOrigPoints; ) {
+    unsigned int iLow = i, iHigh = i, k = i + 1;
+    if (bDecimate) {
+      for (; (k < pData->iNumOrigPoints) && (pXData[k] == pXData[i]); ++k) {
+	if (pYOrig[SORTED(k)] < pYOrig[SORTED(iLow)])
+	  iLow = k;
+	if (pYOrig[SORTED(k)] > pYOrig[SORTED(iHigh)])
+	  iHigh = k;
+      }
+    }
+    const int iColumn = pXData[i];
+    const unsigned int iFirst = (iLow < iHigh) ? iLow : iHigh;
+    const unsigned int iSecond = (iLow < iHigh) ? iHigh : iLow;
+    pXData[j] = iColumn;
+    pYData[j++] = chart_fixed_y_pixel(pData, bounds.size.h, pYOrig[SORTED(iFirst)]);
+    if (iSecond != iFirst) {
+      pXData[j] = iColumn;
+      pYData[j++] = chart_fixed_y_pixel(pData, bounds.size.h, pYOrig[SORTED(iSecond)]);
+    }
+    i = k;
+  }
+  pData->iNumPoints = j;
+#undef SORTED
+
+  // bar width
+  if (pData->typePlot == eBAR) {
+    pData->iBarWidth = (int)(((int64_t)pData->iXScale * iMinXSep) >> FIXED_SHIFT);
+    if (pData->iBarWidth > 2)
+      pData->iBarWidth -= 2;
+  }
+
+  // y-axis position
+  pData->iXAxisIntercept = (int)(((int64_t)pData->iXScale * iMaxX) >> FIXED_SHIFT) + pData->iMargin;
+
+  // points can be appended without a full layout as long as the cached
+  // data maps one to one onto the original data and the x-range follows it
+  pData->bIncremental = pData->bSorted && !bDecimate && (pData->typePlot != eBAR)
+    && (pData->iXWindow > 0) && (pData->iXMin == NOT_SET) && (pData->iXMax == NOT_SET);
+
+  // clean-up
+  pData->iPointsToDraw = 0;
+  free(sort_order);
+}
+
+// appends one point to the laid out data, O(1) unless the y-range changes
+static bool chart_layer_append_layout(ChartLayer* layer, ChartLayerData* pData, bool bRescanY) {
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  if (!pData->bIncremental || pData->bLayoutDirty || !pData->bSorted
+      || ((unsigned int)bounds.size.w - (2 * pData->iMargin)) <= pData->iNumOrigPoints)
+    return false;
+
+  const int32_t* pXOrig = pData->pXOrigInt + pData->iStart;
+  const int32_t* pYOrig = pData->pYOrigInt + pData->iStart;
+  int* pXData = pData->pXData + pData->iStart;
+  int* pYData = pData->pYData + pData->iStart;
+  const unsigned int iLast = pData->iNumOrigPoints - 1;
+
+  // raw y extremes, only rescanned when one of them slid out of the window
+  if (bRescanY || !iLast) {
+    pData->iDataMinY = pData->iDataMaxY = pYOrig[0];
+    for (unsigned int i = 1; i <= iLast; ++i) {
+      if (pYOrig[i] > pData->iDataMaxY)
+	pData->iDataMaxY = pYOrig[i];
+      if (pYOrig[i] < pData->iDataMinY)
+	pData->iDataMinY = pYOrig[i];
+    }
+  }
+  else {
+    if (pYOrig[iLast] > pData->iDataMaxY)
+      pData->iDataMaxY = pYOrig[iLast];
+    if (pYOrig[iLast] < pData->iDataMinY)
+      pData->iDataMinY = pYOrig[iLast];
+  }
+
+  // only a change of y-range moves the points already laid out
+  int32_t iMinY, iMaxY;
+  chart_fixed_y_range(pData, &iMinY, &iMaxY);
+  if ((iMinY != pData->iLayoutMinY) || (iMaxY != pData->iLayoutMaxY)) {
+    pData->iLayoutMinY = iMinY;
+    pData->iLayoutMaxY = iMaxY;
+    chart_fixed_y_scale(pData, bounds.size.h);
+    for (unsigned int i = 0; i < iLast; ++i)
+      pYData[i] = chart_fixed_y_pixel(pData, bounds.size.h, pYOrig[i]);
+  }
+  pYData[iLast] = chart_fixed_y_pixel(pData, bounds.size.h, pYOrig[iLast]);
+
+  // the x-scale is fixed by the window, sliding it only moves the origin
+  const int32_t iMaxX = pXOrig[iLast];
+  const int32_t iMinX = iMaxX - pData->iXWindow + 1;
+  pXData[iLast] = (int)(((int64_t)(pXOrig[iLast] - pData->iXAnchor) * pData->iXScale) >> FIXED_SHIFT);
+  pData->iXShift = pData->iMargin - (int)(((int64_t)(iMinX - pData->iXAnchor) * pData->iXScale) >> FIXED_SHIFT);
+  pData->iXAxisIntercept = (int)(((int64_t)pData->iXScale * iMaxX) >> FIXED_SHIFT) + pData->iMargin;
+
+  pData->iNumPoints = pData->iNumOrigPoints;
+  pData->iPointsToDraw = pData->iNumPoints;
+  return true;
+}
+
+void chart_layer_append_point(ChartLayer* layer, const int x, const int y) {
+  if (layer) {
+    ChartLayerData* pData = get_chart_data(layer);
+
+    // float data can't be appended to, start over as integer data
+    if (!pData->bFixedPoint && pData->iNumOrigPoints) {
+      chart_layer_set_data(layer, &x, eINT, &y, eINT, 1);
+      return;
+    }
+    pData->bFixedPoint = true;
+
+    if (pData->iNumOrigPoints && (x < pData->pXOrigInt[pData->iStart + pData->iNumOrigPoints - 1]))
+      pData->bSorted = false;
+
+    // slide the window
+    bool bRescanY = false;
+    if (pData->iXWindow > 0) {
+      while (pData->iNumOrigPoints && (pData->pXOrigInt[pData->iStart] <= x - pData->iXWindow)) {
+	const int32_t iDropped = pData->pYOrigInt[pData->iStart];
+	if ((iDropped == pData->iDataMinY) || (iDropped == pData->iDataMaxY))
+	  bRescanY = true;
+	++pData->iStart;
+	--pData->iNumOrigPoints;
+	if (pData->iNumPoints)
+	  --pData->iNumPoints;
+      }
+      if (!pData->iNumOrigPoints)
+	pData->iStart = 0;
+    }
+
+    if (!chart_reserve_int(pData, pData->iNumOrigPoints + 1)) {
+      pData->bLayoutDirty = true;
+      chart_layer_invalidate(layer);
+      return;
+    }
+    pData->pXOrigInt[pData->iStart + pData->iNumOrigPoints] = x;
+    pData->pYOrigInt[pData->iStart + pData->iNumOrigPoints] = y;
+    ++pData->iNumOrigPoints;
+
+    if (!chart_layer_append_layout(layer, pData, bRescanY))
+      pData->bLayoutDirty = true;
+
+    chart_layer_invalidate(layer);
+  }
+}
+
 // if needed, prepares data for drawing
 // this is where the heavy lifting is done
 static void chart_layer_update_layout(ChartLayer* layer) {
+  CGM_PERF_SCOPE(CGM_PERF_CHART_LAYOUT);
   if (layer) {
     
     // if nothing to do, return
@@ -334,12 +768,18 @@ static void chart_layer_update_layout(ChartLayer* layer) {
       return;
     pData->bLayoutDirty = false;
 
+    if (pData->bFixedPoint) {
+      chart_layer_update_layout_fixed(layer);
+      return;
+    }
+
     // clear out previously cached values
     if (pData->iNumPoints) {
       free(pData->pXData);
       free(pData->pYData);
     }
     pData->iNumPoints = 0;
+    pData->iXShift = 0;
 
     if (pData->pXOrigData && pData->pYOrigData && pData->iNumOrigPoints) {
       // figure out sort order
@@ -355,14 +795,14 @@ static void chart_layer_update_layout(ChartLayer* layer) {
       const unsigned int iSampling = ((pData->typePlot == eSCATTER) || (((unsigned int)bounds.size.w - (2 * pData->iMargin)) > pData->iNumOrigPoints)) ? 1 : pData->iNumOrigPoints / ((unsigned int)bounds.size.w - (2 * pData->iMargin));
 
       // init for cached data
-      pData->iNumPoints = pData->iNumOrigPoints / iSampling;
+      pData->iNumPoints = (pData->iNumOrigPoints + iSampling - 1) / iSampling;
       pData->pXData = (int*)malloc(pData->iNumPoints * sizeof(int));
       pData->pYData = (int*)malloc(pData->iNumPoints * sizeof(int));
       
-      // figure out Y-scale
+      // figure out Y-scale over all points, not just the sampled ones
       float fMaxY = pData->pYOrigData[0];
       float fMinY = pData->pYOrigData[0];
-      for (unsigned int i = 0; i < pData->iNumOrigPoints; i += iSampling) {
+      for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i) {
 	if (pData->pYOrigData[i] > fMaxY)
 	  fMaxY = pData->pYOrigData[i];
 	if (pData->pYOrigData[i] < fMinY)
@@ -375,9 +815,9 @@ static void chart_layer_update_layout(ChartLayer* layer) {
   // fMaxY = fMaxY + (fMaxY - fMinY)*.25;
   // fMinY = fMinY - (fMaxY - fMinY)*.25;
   
-  pData->fXYRange = (fMaxY - fMinY);
-  if (pData->fXYRange < 30) {
-    float diff = (30 - pData->fXYRange);
+  float fXYRange = (fMaxY - fMinY);
+  if (fXYRange < 30) {
+    float diff = (30 - fXYRange);
     fMaxY = fMaxY + diff;
     fMinY = fMinY - diff;
     
@@ -386,8 +826,9 @@ static void chart_layer_update_layout(ChartLayer* layer) {
     if (fMaxY > 400)
       fMaxY = 400;
       
-    pData->fXYRange = 30;
+    fXYRange = 30;
   }
+  pData->iXYRange = (int)fXYRange;
 
       const float fYScale = (float)(bounds.size.h - (2 * pData->iMargin)) / (fMaxY - fMinY);
 
@@ -461,14 +902,14 @@ static void animation_update(Animation* animation, const uint32_t time_normalize
   if (time_normalized == ANIMATION_NORMALIZED_MAX)
     data->iPointsToDraw = data->iNumPoints;
   else
-    data->iPointsToDraw = (int) (data->iNumPoints * ((float)time_normalized/(float)ANIMATION_NORMALIZED_MAX));
+    data->iPointsToDraw = (int) ((data->iNumPoints * time_normalized) / ANIMATION_NORMALIZED_MAX);
   
   // trigger re-draw
-  layer_mark_dirty(chart_layer_get_layer(layer));
+  chart_layer_invalidate(layer);
 }
 
 // function to draw chart
-static void chart_layer_update_func(Layer* l, GContext* ctx) {
+static void chart_layer_draw(Layer* l, GContext* ctx) {
   ChartLayer* layer = (ChartLayer*)l;
   chart_layer_update_layout(layer);
 
@@ -490,11 +931,11 @@ static void chart_layer_update_func(Layer* l, GContext* ctx) {
   
   GRect bounds = layer_get_bounds(l);
 
-  // draw background
+  // draw background over the whole layer, as all of it ends up in the cache
   GRect canvas = (GRect) { .origin = { 0, 0 },
 			   .size = { bounds.size.w-1, bounds.size.h-1 } };
   graphics_context_set_fill_color(ctx, data->clrCanvas);
-  graphics_fill_rect(ctx, canvas, 0, 0);
+  graphics_fill_rect(ctx, (GRect) { .origin = { 0, 0 }, .size = bounds.size }, 0, 0);
 
   // set color for rest of draw cycle
   graphics_context_set_fill_color(ctx, data->clrPlot);
@@ -561,24 +1002,23 @@ static void chart_layer_update_func(Layer* l, GContext* ctx) {
 		// 	 .x = data->iXAxisIntercept,
 		// 	   .y = bounds.size.h - data->iMargin }));
     
-    int range = (int)(data->fYMax) - (int)(data->fYMin); 
     uint16_t iPointRadius = 1;  
 
-     APP_LOG(APP_LOG_LEVEL_DEBUG, "range2: %i", (int)(data->fXYRange));
+    CGM_LOG_DEBUG(CHART, "range2: %i", data->iXYRange);
  
-    if ((int)(data->fXYRange)<= 30) {
+    if (data->iXYRange<= 30) {
         if ((int)data->iPointsToDraw <= 12)
             iPointRadius = 4;
         else
             iPointRadius = 0;
     } 
-    else if ((int)(data->fXYRange) <= 60)  {
+    else if (data->iXYRange <= 60)  {
         if ((int)data->iPointsToDraw <= 12)
             iPointRadius = 3;
         else
             iPointRadius = 0;
     }
-    else if ((int)(data->fXYRange) <= 100)  {
+    else if (data->iXYRange <= 100)  {
         if ((int)data->iPointsToDraw <= 12)
             iPointRadius = 2;
         else
@@ -593,7 +1033,7 @@ static void chart_layer_update_func(Layer* l, GContext* ctx) {
     // main plot
 // #ifdef PBL_PLATFORM_BASALT
         data->typePlot = eLINE;
-    if ((int)(data->fXYRange) <= 30) {
+    if (data->iXYRange <= 30) {
         if ((int)data->iPointsToDraw <= 12) {
              graphics_context_set_stroke_width(ctx, 0);
             graphics_context_set_stroke_color(ctx, GColorClear); 
@@ -603,11 +1043,11 @@ static void chart_layer_update_func(Layer* l, GContext* ctx) {
         
         //data->typePlot = eSCATTER;
     } 
-    else if ((int)(data->fXYRange) <= 60)  {
+    else if (data->iXYRange <= 60)  {
         graphics_context_set_stroke_width(ctx, 2);
 
     }
-    else if ((int)(data->fXYRange) <= 100)  {
+    else if (data->iXYRange <= 100)  {
         graphics_context_set_stroke_width(ctx, 1);
     } else 
     {
@@ -617,25 +1057,28 @@ static void chart_layer_update_func(Layer* l, GContext* ctx) {
     //const uint16_t iPointRadius = ((data->typePlot == eLINE) || (data->iNumOrigPoints < ((unsigned int)bounds.size.w / 3))) ? 4 : 3;
 // #endif
 
-APP_LOG(APP_LOG_LEVEL_DEBUG, "radius: %i", iPointRadius);  
+    CGM_LOG_DEBUG(CHART, "radius: %i", iPointRadius);
 
     const bool bShowPoints = (data->typePlot != eBAR) && ((data->typePlot == eSCATTER) || (data->bShowPoints && (data->iNumOrigPoints < ((unsigned int)bounds.size.w / 3))));
 
+    const int* pXData = data->pXData + data->iStart;
+    const int* pYData = data->pYData + data->iStart;
+    const int iXShift = data->iXShift;
     for (unsigned int i = 0; i < data->iPointsToDraw; ++i) {
       if ((data->typePlot == eLINE) && (i != data->iNumPoints-1)) {
 	graphics_draw_line(ctx, 
 			   ((GPoint) { 
-			     .x = data->pXData[i],
-			       .y = data->pYData[i] }),
+			     .x = pXData[i] + iXShift,
+			       .y = pYData[i] }),
 			   ((GPoint) {
-			     .x = data->pXData[i+1],
-			       .y = data->pYData[i+1] }));
+			     .x = pXData[i+1] + iXShift,
+			       .y = pYData[i+1] }));
       }
       else if (data->typePlot == eBAR) {
 	graphics_fill_rect(ctx,
 			   ((GRect) {
-			     .origin = { data->pXData[i] - (data->iBarWidth / 2), data->pYData[i] },
-			       .size = { data->iBarWidth, (((data->iYAxisIntercept > (bounds.size.h - data->iMargin)) ? (bounds.size.h - data->iMargin) : data->iYAxisIntercept) - data->pYData[i]) } }),
+			     .origin = { pXData[i] + iXShift - (data->iBarWidth / 2), pYData[i] },
+			       .size = { data->iBarWidth, (((data->iYAxisIntercept > (bounds.size.h - data->iMargin)) ? (bounds.size.h - data->iMargin) : data->iYAxisIntercept) - pYData[i]) } }),
 			   0,
 			   GCornersAll);
       }
@@ -643,13 +1086,92 @@ APP_LOG(APP_LOG_LEVEL_DEBUG, "radius: %i", iPointRadius);
       if (bShowPoints) {
 	graphics_fill_circle(ctx, 
 			     ((GPoint) {
-			       .x = data->pXData[i],
-				 .y = data->pYData[i] } ), iPointRadius);
+			       .x = pXData[i] + iXShift,
+				 .y = pYData[i] } ), iPointRadius);
       }
     }
   }
 }
 
+// where the cache goes, in layer coordinates
+static GRect chart_layer_cache_rect(Layer* l) {
+  ChartLayerData* data = get_chart_data((ChartLayer*)l);
+  const GRect frame = layer_get_frame(l);
+  const GRect cache = gbitmap_get_bounds(data->pCache);
+  return (GRect) { .origin = { -frame.origin.x, 0 }, .size = cache.size };
+}
+
+// copies what was just drawn from the frame buffer into the cache
+// whole frame buffer rows are copied, so the ChartLayer is expected to be
+// a direct child of the window's root layer
+static bool chart_layer_capture(Layer* l, GContext* ctx) {
+  ChartLayerData* data = get_chart_data((ChartLayer*)l);
+  const GRect frame = layer_get_frame(l);
+
+  GBitmap* pFrameBuffer = graphics_capture_frame_buffer(ctx);
+  if (!pFrameBuffer)
+    return false;
+
+  const GRect screen = gbitmap_get_bounds(pFrameBuffer);
+  bool bCaptured = false;
+  if ((frame.origin.y >= 0) && (frame.origin.y + frame.size.h <= screen.size.h)) {
+#ifdef PBL_ROUND
+    // the round frame buffer has rows of varying length, cache it as a rectangle
+    const GBitmapFormat format = GBitmapFormat8Bit;
+#else
+    const GBitmapFormat format = gbitmap_get_format(pFrameBuffer);
+#endif
+    const GSize size = { screen.size.w, frame.size.h };
+    if (data->pCache) {
+      const GRect cache = gbitmap_get_bounds(data->pCache);
+      if ((cache.size.w != size.w) || (cache.size.h != size.h) || (gbitmap_get_format(data->pCache) != format)) {
+	gbitmap_destroy(data->pCache);
+	data->pCache = NULL;
+      }
+    }
+    if (!data->pCache)
+      data->pCache = gbitmap_create_blank(size, format);
+
+    if (data->pCache) {
+      for (int y = 0; y < size.h; ++y) {
+#ifdef PBL_ROUND
+	const GBitmapDataRowInfo src = gbitmap_get_data_row_info(pFrameBuffer, frame.origin.y + y);
+	const GBitmapDataRowInfo dst = gbitmap_get_data_row_info(data->pCache, y);
+	memcpy(dst.data + src.min_x, src.data + src.min_x, src.max_x - src.min_x + 1);
+#else
+	const uint16_t iSrcRow = gbitmap_get_bytes_per_row(pFrameBuffer);
+	const uint16_t iDstRow = gbitmap_get_bytes_per_row(data->pCache);
+	memcpy(gbitmap_get_data(data->pCache) + (y * iDstRow),
+	       gbitmap_get_data(pFrameBuffer) + ((frame.origin.y + y) * iSrcRow),
+	       (iSrcRow < iDstRow) ? iSrcRow : iDstRow);
+#endif
+      }
+      bCaptured = true;
+    }
+  }
+
+  graphics_release_frame_buffer(ctx, pFrameBuffer);
+  return bCaptured;
+}
+
+// draws the chart from the cache, rasterizing it first if it changed
+static void chart_layer_update_func(Layer* l, GContext* ctx) {
+  CGM_PERF_SCOPE(CGM_PERF_CHART_DRAW);
+  ChartLayerData* data = get_chart_data((ChartLayer*)l);
+
+  if (!data->bCacheDirty && data->pCache) {
+    graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+    graphics_draw_bitmap_in_rect(ctx, data->pCache, chart_layer_cache_rect(l));
+    return;
+  }
+
+  chart_layer_draw(l, ctx);
+
+  // only a finished drawing over an opaque canvas can stand in for the chart
+  if ((data->iPointsToDraw == data->iNumPoints) && !gcolor_equal(data->clrCanvas, GColorClear))
+    data->bCacheDirty = !chart_layer_capture(l, ctx);
+}
+
 ///////////////////////////////////
 // math helpers
 
@@ -686,4 +1208,14 @@ static float exponential10(int exp) {
   return f;
 }
 
+// integer counterpart of exponential10(closest_log10(num)) for num >= 1
+static int32_t floor_power10(int32_t num) {
+  int32_t p = 1;
+  while (num > 10) {
+    num = num / 10;
+    p = p * 10;
+  }
+  return p;
+}
+
 ///////////////////////////////////
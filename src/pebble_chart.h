@@ -51,6 +51,10 @@ typedef enum {
 //! If there are too many points to display given the
 //! width of the ChartLayer, the data points displayed will
 //! be a sampling of the original data points.
+//! When both axes are `eINT` the layout is done in fixed-point
+//! integer math; otherwise it is done in `float`. `eINT` data
+//! is not sampled but decimated to the lowest and highest point
+//! of each pixel column, so no excursion is lost.
 //! @param layer The ChartLayer to display the chart
 //! @param pX The array containing the x-values
 //! @param typeX The data type of `pX`'s values
@@ -64,6 +68,17 @@ void chart_layer_set_data(ChartLayer* layer,
 			  const ChartDataType typeY,
 			  const unsigned int iNumPoints);
 
+//! Appends a single `eINT` point to the chart data.
+//! When the x-values arrive in order and an x window is set, the point
+//! is laid out on its own and the rest of the chart only moves if the
+//! y-range changes, instead of a full layout of the data set.
+//! Points that fall out of the x window are dropped.
+//! Data previously set as `eFLOAT` is replaced by the point.
+//! @param layer The ChartLayer to which to append the point
+//! @param x The x-value of the point
+//! @param y The y-value of the point
+void chart_layer_append_point(ChartLayer* layer, const int x, const int y);
+
 //! Enum of supported plot types
 typedef enum {
   eLINE,
@@ -172,3 +187,13 @@ void chart_layer_animate(ChartLayer* layer, bool bAnimate);
 //! @param layer The ChartLayer to which to apply the duration
 //! @param ms The duration of the animation in milliseconds
 void chart_layer_set_animation_duration(ChartLayer* layer, const uint32_t ms);
+
+//! Sets a sliding x window for `eINT` data: the x-axis spans the
+//! `window` values up to and including the largest x-value, and
+//! chart_layer_append_point() drops points older than that.
+//! Explicit x minimum/maximum take precedence. Has no impact on
+//! `eFLOAT` data.
+//! Will redraw chart if chart data is set.
+//! @param layer The ChartLayer to which to set the window
+//! @param window The width of the window in x units, 0 to turn it off
+void chart_layer_set_x_window(ChartLayer* layer, const int window);
@@ -0,0 +1,167 @@
+/**
+ * Micro-benchmarks of the watch face's hot paths at 9, 96 and 288 readings (45 minutes, 8 hours and a day of BG
+ * history), reporting the time and heap allocations per call. Host numbers only compare one build with another; the
+ * watch is two orders of magnitude slower.
+ *
+ *   parse    data_processor_parse_int_array over a CSV of readings
+ *   set_data chart_layer_set_data, which copies the readings and leaves the layout to the next redraw
+ *   layout   that layout on its own
+ *   inbox    `bgs` packets through bg_packet_parse and bg_chart, the code inbox_received_callback runs on them, and the
+ *            layout of the chart they leave behind. A packet holds at most 255 readings, so 288 take a full packet of
+ *            the oldest readings and then one appending the rest, as two replies from the phone would
+ */
+#include <pebble.h>
+
+#include "bg_chart.h"
+#include "bg_packet.h"
+#include "data-processor.h"
+
+// for chart_layer_update_layout, which is static
+#include "pebble_chart.c"
+
+#define MIN_SECONDS 0.2
+
+static const int SIZES[] = { 9, 96, 288 };
+
+typedef void (*BenchFn)(int points);
+
+static double now_seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Runs `fn` often enough to take MIN_SECONDS and prints the mean time and allocations per call.
+ */
+static void run(const char *name, BenchFn fn, int points) {
+    fn(points);     // warm up, and let any lazily grown buffers reach their size
+    long iterations = 0;
+    shim_heap_reset();
+    double start = now_seconds(), elapsed;
+    do {
+        for (int i = 0; i < 100; i++) {
+            fn(points);
+        }
+        iterations += 100;
+        elapsed = now_seconds() - start;
+    } while (elapsed < MIN_SECONDS);
+    printf("%-8s %4d points %10.0f ns/op %8.2f allocs/op\n", name, points,
+           elapsed * 1e9 / iterations, (double) shim_heap_stats().allocs / iterations);
+}
+
+static int s_x[288], s_y[288];
+
+static void fill_readings() {
+    for (int i = 0; i < 288; i++) {
+        s_x[i] = 28000000 + i * 5;
+        s_y[i] = 120 + (i * 37) % 160 - 60;
+    }
+}
+
+/*********************************** parse ************************************/
+
+static char s_csv[288 * 5];
+
+static void bench_parse(int points) {
+    static char data[sizeof(s_csv)];
+    int values[288];
+    strcpy(data, s_csv);
+    ProcessingState state;
+    data_processor_init_state(&state, data, ',');
+    data_processor_parse_int_array(&state, values, points);
+}
+
+/*********************************** layout ***********************************/
+
+static ChartLayer *s_chart;
+
+static void bench_set_data(int points) {
+    chart_layer_set_data(s_chart, s_x, eINT, s_y, eINT, points);
+}
+
+static void bench_layout(int points) {
+    get_chart_data(s_chart)->bLayoutDirty = true;
+    chart_layer_update_layout(s_chart);
+}
+
+/*********************************** inbox ************************************/
+
+#define MAX_PACKET_RECORDS 255
+
+static uint8_t s_packets[2][sizeof(Tuple) + BG_PACKET_HEADER_SIZE + MAX_PACKET_RECORDS * BG_PACKET_RECORD_SIZE];
+static int s_num_packets;
+// set up like the spark line on the watch face
+static ChartLayer *s_face_chart;
+
+/**
+ * Packs the readings from `first` up to, not including, `last` as a `bgs` tuple, newest first.
+ */
+static void make_packet(uint8_t *buffer, int first, int last, uint8_t flags) {
+    int count = last - first;
+    uint32_t newest = s_x[last - 1] * 60;
+    uint8_t data[BG_PACKET_HEADER_SIZE + MAX_PACKET_RECORDS * BG_PACKET_RECORD_SIZE] = {
+        BG_PACKET_VERSION, count, flags, 0,
+        newest & 0xFF, (newest >> 8) & 0xFF, (newest >> 16) & 0xFF, newest >> 24
+    };
+    for (int i = 0; i < count; i++) {
+        uint8_t *record = &data[BG_PACKET_HEADER_SIZE + i * BG_PACKET_RECORD_SIZE];
+        uint16_t minutes = (s_x[last - 1] - s_x[last - 1 - i]);
+        int16_t mgdl = s_y[last - 1 - i];
+        record[0] = minutes & 0xFF;
+        record[1] = minutes >> 8;
+        record[2] = mgdl & 0xFF;
+        record[3] = (uint16_t) mgdl >> 8;
+    }
+    shim_tuple_bytes(buffer, 7, data, BG_PACKET_HEADER_SIZE + count * BG_PACKET_RECORD_SIZE);
+}
+
+static void make_packets(int points) {
+    int split = points > MAX_PACKET_RECORDS ? points - MAX_PACKET_RECORDS : points;
+    make_packet(s_packets[0], 0, split, BG_PACKET_FLAG_FULL);
+    s_num_packets = 1;
+    if (split < points) {
+        make_packet(s_packets[1], split, points, 0);
+        s_num_packets = 2;
+    }
+}
+
+static void bench_inbox(int points) {
+    for (int i = 0; i < s_num_packets; i++) {
+        BgPacket packet;
+        bg_packet_parse(&packet, (const Tuple *) s_packets[i]);
+        if (bg_chart_apply_packet(s_face_chart, &packet)) {
+            bg_chart_refresh(s_face_chart);
+        }
+        chart_layer_update_layout(s_face_chart);
+    }
+}
+
+/************************************ Main ************************************/
+
+int main(void) {
+    fill_readings();
+    s_chart = chart_layer_create(GRect(0, 0, 144, 70));
+    chart_layer_animate(s_chart, false);
+    s_face_chart = chart_layer_create(GRect(0, 0, 136, 62));
+    chart_layer_animate(s_face_chart, false);
+    chart_layer_set_margin(s_face_chart, 7);
+    chart_layer_set_x_window(s_face_chart, BG_CHART_WINDOW_MINUTES);
+
+    for (size_t i = 0; i < ARRAY_LENGTH(SIZES); i++) {
+        int points = SIZES[i];
+        char *pos = s_csv;
+        for (int n = 0; n < points; n++) {
+            pos += sprintf(pos, n ? ",%d" : "%d", s_y[n]);
+        }
+        run("parse", bench_parse, points);
+        run("set_data", bench_set_data, points);
+        run("layout", bench_layout, points);
+        make_packets(points);
+        run("inbox", bench_inbox, points);
+    }
+
+    chart_layer_destroy(s_chart);
+    chart_layer_destroy(s_face_chart);
+    return 0;
+}
@@ -0,0 +1,297 @@
+#pragma once
+
+//! Host stand-in for the parts of the Pebble SDK used by the modules built in
+//! test/Makefile, so they can be tested and benchmarked natively.
+//!
+//! Layers and bitmaps are plain heap objects, drawing calls are counted in the
+//! GContext instead of rasterized, animations never run, persistent storage
+//! lives in memory and APP_LOG goes to stderr, debug levels only when
+//! PEBBLE_LOG_DEBUG is set in the environment. malloc and friends are routed
+//! through counters so tests and benchmarks can see what a call allocates.
+//!
+//! Only what the built modules use is declared; add to it as they grow.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+/*********************************** Heap *************************************/
+
+//! Counts of every allocation made through the shim since the last reset.
+typedef struct {
+    size_t allocs;
+    size_t frees;
+    size_t bytes;
+} ShimHeapStats;
+
+void *shim_malloc(size_t size);
+void *shim_calloc(size_t count, size_t size);
+void *shim_realloc(void *ptr, size_t size);
+void shim_free(void *ptr);
+void shim_heap_reset(void);
+ShimHeapStats shim_heap_stats(void);
+
+#define malloc(size) shim_malloc(size)
+#define calloc(count, size) shim_calloc(count, size)
+#define realloc(ptr, size) shim_realloc(ptr, size)
+#define free(ptr) shim_free(ptr)
+
+size_t heap_bytes_used(void);
+size_t heap_bytes_free(void);
+
+/********************************* Logging ************************************/
+
+#define APP_LOG_LEVEL_ERROR 1
+#define APP_LOG_LEVEL_WARNING 50
+#define APP_LOG_LEVEL_INFO 100
+#define APP_LOG_LEVEL_DEBUG 200
+#define APP_LOG_LEVEL_DEBUG_VERBOSE 255
+
+void app_log(uint8_t level, const char *filename, int line, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+#define APP_LOG(level, fmt, ...) app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+/*********************************** Time *************************************/
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+
+/******************************** Geometry ************************************/
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+} GPoint;
+
+typedef struct {
+    int16_t w;
+    int16_t h;
+} GSize;
+
+typedef struct {
+    GPoint origin;
+    GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint) { (x), (y) })
+#define GSize(w, h) ((GSize) { (w), (h) })
+#define GRect(x, y, w, h) ((GRect) { { (x), (y) }, { (w), (h) } })
+#define GPointZero GPoint(0, 0)
+
+typedef enum {
+    GCornerNone = 0,
+    GCornerTopLeft = 1 << 0,
+    GCornerTopRight = 1 << 1,
+    GCornerBottomLeft = 1 << 2,
+    GCornerBottomRight = 1 << 3,
+    GCornersAll = GCornerTopLeft | GCornerTopRight | GCornerBottomLeft | GCornerBottomRight,
+} GCornerMask;
+
+/********************************* Colours ************************************/
+
+typedef union {
+    uint8_t argb;
+    struct {
+        uint8_t b:2;
+        uint8_t g:2;
+        uint8_t r:2;
+        uint8_t a:2;
+    };
+} GColor;
+
+#define GColorClear ((GColor) { .argb = 0x00 })
+#define GColorBlack ((GColor) { .argb = 0xC0 })
+#define GColorWhite ((GColor) { .argb = 0xFF })
+
+bool gcolor_equal(GColor a, GColor b);
+
+/********************************* Bitmaps ************************************/
+
+typedef enum {
+    GBitmapFormat1Bit,
+    GBitmapFormat8Bit,
+    GBitmapFormat1BitPalette,
+    GBitmapFormat2BitPalette,
+    GBitmapFormat4BitPalette,
+    GBitmapFormat8BitCircular,
+} GBitmapFormat;
+
+typedef enum {
+    GCompOpAssign,
+    GCompOpAssignInverted,
+    GCompOpOr,
+    GCompOpAnd,
+    GCompOpClear,
+    GCompOpSet,
+} GCompOp;
+
+typedef struct GBitmap GBitmap;
+
+typedef struct {
+    uint8_t *data;
+    int16_t min_x;
+    int16_t max_x;
+} GBitmapDataRowInfo;
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+void gbitmap_destroy(GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y);
+
+/********************************* Drawing ************************************/
+
+//! Counts of the drawing calls made on a context, in place of the pixels.
+typedef struct {
+    unsigned lines;
+    unsigned rects;
+    unsigned circles;
+    unsigned bitmaps;
+    unsigned state;
+} ShimDrawStats;
+
+//! A line drawn on a context, kept so tests can check where things land.
+typedef struct {
+    GPoint p0;
+    GPoint p1;
+} ShimLine;
+
+//! How many lines a context keeps; the counts in ShimDrawStats go on past it.
+#define SHIM_MAX_LINES 512
+
+typedef struct GContext GContext;
+
+GContext *shim_context_create(void);
+void shim_context_destroy(GContext *ctx);
+ShimDrawStats shim_context_stats(const GContext *ctx);
+//! The first SHIM_MAX_LINES lines drawn on `ctx`, in the order they were drawn.
+//! @param count Out: the number of lines returned.
+const ShimLine *shim_context_lines(const GContext *ctx, unsigned *count);
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t width);
+void graphics_context_set_antialiased(GContext *ctx, bool enable);
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+void graphics_draw_rect(GContext *ctx, GRect rect);
+void graphics_draw_round_rect(GContext *ctx, GRect rect, uint16_t radius);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect);
+//! Always NULL: the shim has no frame buffer to hand out.
+GBitmap *graphics_capture_frame_buffer(GContext *ctx);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+
+/********************************** Layers ************************************/
+
+typedef struct Layer Layer;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer *layer_create(GRect frame);
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void *layer_get_data(const Layer *layer);
+GRect layer_get_frame(const Layer *layer);
+GRect layer_get_bounds(const Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer *layer);
+
+//! Runs the layer's update proc on `ctx`, as a redraw would.
+void shim_layer_render(Layer *layer, GContext *ctx);
+//! The number of layer_mark_dirty calls on the layer.
+unsigned shim_layer_dirty_count(const Layer *layer);
+
+/******************************** Animation ***********************************/
+
+#define ANIMATION_NORMALIZED_MIN 0
+#define ANIMATION_NORMALIZED_MAX 65535
+
+typedef struct Animation Animation;
+
+typedef enum {
+    AnimationCurveLinear,
+    AnimationCurveEaseIn,
+    AnimationCurveEaseOut,
+    AnimationCurveEaseInOut,
+} AnimationCurve;
+
+typedef void (*AnimationStartedHandler)(Animation *animation, void *context);
+typedef void (*AnimationStoppedHandler)(Animation *animation, bool finished, void *context);
+
+typedef struct {
+    AnimationStartedHandler started;
+    AnimationStoppedHandler stopped;
+} AnimationHandlers;
+
+typedef void (*AnimationSetupImplementation)(Animation *animation);
+typedef void (*AnimationUpdateImplementation)(Animation *animation, const uint32_t time_normalized);
+typedef void (*AnimationTeardownImplementation)(Animation *animation);
+
+typedef struct AnimationImplementation {
+    AnimationSetupImplementation setup;
+    AnimationUpdateImplementation update;
+    AnimationTeardownImplementation teardown;
+} AnimationImplementation;
+
+//! Animations are never scheduled on the host; use chart_layer_animate(false).
+Animation *animation_create(void);
+bool animation_destroy(Animation *animation);
+bool animation_set_curve(Animation *animation, AnimationCurve curve);
+bool animation_set_handlers(Animation *animation, AnimationHandlers handlers, void *context);
+bool animation_set_implementation(Animation *animation, const AnimationImplementation *implementation);
+void *animation_get_context(Animation *animation);
+bool animation_set_duration(Animation *animation, uint32_t duration_ms);
+bool animation_schedule(Animation *animation);
+bool animation_is_scheduled(Animation *animation);
+
+/******************************** Dictionary **********************************/
+
+typedef enum {
+    TUPLE_BYTE_ARRAY = 0,
+    TUPLE_CSTRING = 1,
+    TUPLE_UINT = 2,
+    TUPLE_INT = 3,
+} TupleType;
+
+typedef struct __attribute__((__packed__)) {
+    uint32_t key;
+    TupleType type:8;
+    uint16_t length;
+    union {
+        uint8_t data[0];
+        char cstring[0];
+        uint8_t uint8;
+        uint16_t uint16;
+        uint32_t uint32;
+        int8_t int8;
+        int16_t int16;
+        int32_t int32;
+    } value[];
+} Tuple;
+
+//! Lays out a byte array tuple in `buffer`, which must hold sizeof(Tuple) + length bytes.
+Tuple *shim_tuple_bytes(void *buffer, uint32_t key, const uint8_t *data, uint16_t length);
+
+/******************************** Persistence *********************************/
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+bool persist_exists(const uint32_t key);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+int persist_write_data(const uint32_t key, const void *data, const size_t size);
+int32_t persist_read_int(const uint32_t key);
+int persist_write_int(const uint32_t key, const int32_t value);
+int persist_delete(const uint32_t key);
+//! Forgets everything written, as a fresh install would.
+void shim_persist_reset(void);
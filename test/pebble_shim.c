@@ -0,0 +1,402 @@
+#include "pebble.h"
+
+#include <stdarg.h>
+#include <sys/time.h>
+
+/****************************** Logging and time ******************************/
+
+void app_log(uint8_t level, const char *filename, int line, const char *fmt, ...) {
+    if (level > APP_LOG_LEVEL_INFO && !getenv("PEBBLE_LOG_DEBUG")) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "[%u] %s:%d ", level, filename, line);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    uint16_t ms = (uint16_t) (now.tv_usec / 1000);
+    if (tloc) {
+        *tloc = now.tv_sec;
+    }
+    if (out_ms) {
+        *out_ms = ms;
+    }
+    return ms;
+}
+
+/********************************** Colours ***********************************/
+
+bool gcolor_equal(GColor a, GColor b) {
+    return a.argb == b.argb || (a.a == 0 && b.a == 0);
+}
+
+/********************************** Bitmaps ***********************************/
+
+struct GBitmap {
+    GSize size;
+    GBitmapFormat format;
+    uint16_t bytes_per_row;
+    uint8_t *data;
+};
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format) {
+    GBitmap *bitmap = calloc(1, sizeof(GBitmap));
+    bitmap->size = size;
+    bitmap->format = format;
+    bitmap->bytes_per_row = (format == GBitmapFormat1Bit) ? ((size.w + 31) / 32) * 4 : size.w;
+    bitmap->data = calloc(size.h, bitmap->bytes_per_row);
+    return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+    if (bitmap) {
+        free(bitmap->data);
+        free(bitmap);
+    }
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+    return (GRect) { GPointZero, bitmap->size };
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+    return bitmap->format;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+    return bitmap->bytes_per_row;
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+    return bitmap->data;
+}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y) {
+    return (GBitmapDataRowInfo) {
+        .data = bitmap->data + y * bitmap->bytes_per_row,
+        .min_x = 0,
+        .max_x = bitmap->size.w - 1,
+    };
+}
+
+/********************************** Drawing ***********************************/
+
+struct GContext {
+    ShimDrawStats stats;
+    ShimLine lines[SHIM_MAX_LINES];
+};
+
+GContext *shim_context_create(void) {
+    return calloc(1, sizeof(GContext));
+}
+
+void shim_context_destroy(GContext *ctx) {
+    free(ctx);
+}
+
+ShimDrawStats shim_context_stats(const GContext *ctx) {
+    return ctx->stats;
+}
+
+const ShimLine *shim_context_lines(const GContext *ctx, unsigned *count) {
+    *count = ctx->stats.lines < SHIM_MAX_LINES ? ctx->stats.lines : SHIM_MAX_LINES;
+    return ctx->lines;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+    ctx->stats.state++;
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+    ctx->stats.state++;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+    ctx->stats.state++;
+}
+
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t width) {
+    ctx->stats.state++;
+}
+
+void graphics_context_set_antialiased(GContext *ctx, bool enable) {
+    ctx->stats.state++;
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+    ctx->stats.state++;
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+    if (ctx->stats.lines < SHIM_MAX_LINES) {
+        ctx->lines[ctx->stats.lines] = (ShimLine) { p0, p1 };
+    }
+    ctx->stats.lines++;
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+    ctx->stats.rects++;
+}
+
+void graphics_draw_round_rect(GContext *ctx, GRect rect, uint16_t radius) {
+    ctx->stats.rects++;
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+    ctx->stats.rects++;
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+    ctx->stats.circles++;
+}
+
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius) {
+    ctx->stats.circles++;
+}
+
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+    ctx->stats.bitmaps++;
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+    return NULL;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+    return true;
+}
+
+/********************************** Layers ************************************/
+
+struct Layer {
+    GRect frame;
+    LayerUpdateProc update_proc;
+    unsigned dirty;
+    uint8_t data[];
+};
+
+Layer *layer_create(GRect frame) {
+    return layer_create_with_data(frame, 0);
+}
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+    Layer *layer = calloc(1, sizeof(Layer) + data_size);
+    layer->frame = frame;
+    return layer;
+}
+
+void layer_destroy(Layer *layer) {
+    free(layer);
+}
+
+void *layer_get_data(const Layer *layer) {
+    return (void *) layer->data;
+}
+
+GRect layer_get_frame(const Layer *layer) {
+    return layer->frame;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+    return (GRect) { GPointZero, layer->frame.size };
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+    layer->update_proc = update_proc;
+}
+
+void layer_mark_dirty(Layer *layer) {
+    layer->dirty++;
+}
+
+void shim_layer_render(Layer *layer, GContext *ctx) {
+    if (layer->update_proc) {
+        layer->update_proc(layer, ctx);
+    }
+}
+
+unsigned shim_layer_dirty_count(const Layer *layer) {
+    return layer->dirty;
+}
+
+/********************************* Animation **********************************/
+
+struct Animation {
+    void *context;
+};
+
+Animation *animation_create(void) {
+    return calloc(1, sizeof(Animation));
+}
+
+bool animation_destroy(Animation *animation) {
+    free(animation);
+    return true;
+}
+
+bool animation_set_curve(Animation *animation, AnimationCurve curve) {
+    return true;
+}
+
+bool animation_set_handlers(Animation *animation, AnimationHandlers handlers, void *context) {
+    animation->context = context;
+    return true;
+}
+
+bool animation_set_implementation(Animation *animation, const AnimationImplementation *implementation) {
+    return true;
+}
+
+void *animation_get_context(Animation *animation) {
+    return animation->context;
+}
+
+bool animation_set_duration(Animation *animation, uint32_t duration_ms) {
+    return true;
+}
+
+bool animation_schedule(Animation *animation) {
+    return false;
+}
+
+bool animation_is_scheduled(Animation *animation) {
+    return false;
+}
+
+/********************************* Dictionary *********************************/
+
+Tuple *shim_tuple_bytes(void *buffer, uint32_t key, const uint8_t *data, uint16_t length) {
+    Tuple *tuple = buffer;
+    tuple->key = key;
+    tuple->type = TUPLE_BYTE_ARRAY;
+    tuple->length = length;
+    memcpy(tuple->value->data, data, length);
+    return tuple;
+}
+
+/******************************** Persistence *********************************/
+
+#define PERSIST_MAX_KEYS 64
+
+static struct {
+    uint32_t key;
+    size_t size;
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} s_persist[PERSIST_MAX_KEYS];
+static int s_persist_count;
+
+static int persist_find(uint32_t key) {
+    for (int i = 0; i < s_persist_count; i++) {
+        if (s_persist[i].key == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool persist_exists(const uint32_t key) {
+    return persist_find(key) >= 0;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+    int i = persist_find(key);
+    if (i < 0) {
+        return -1;
+    }
+    size_t size = s_persist[i].size < buffer_size ? s_persist[i].size : buffer_size;
+    memcpy(buffer, s_persist[i].data, size);
+    return (int) size;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+    int i = persist_find(key);
+    if (i < 0) {
+        if (s_persist_count == PERSIST_MAX_KEYS) {
+            return -1;
+        }
+        i = s_persist_count++;
+        s_persist[i].key = key;
+    }
+    s_persist[i].size = size < PERSIST_DATA_MAX_LENGTH ? size : PERSIST_DATA_MAX_LENGTH;
+    memcpy(s_persist[i].data, data, s_persist[i].size);
+    return (int) s_persist[i].size;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+    int32_t value = 0;
+    persist_read_data(key, &value, sizeof(value));
+    return value;
+}
+
+int persist_write_int(const uint32_t key, const int32_t value) {
+    return persist_write_data(key, &value, sizeof(value));
+}
+
+int persist_delete(const uint32_t key) {
+    int i = persist_find(key);
+    if (i >= 0) {
+        s_persist[i] = s_persist[--s_persist_count];
+    }
+    return 0;
+}
+
+void shim_persist_reset(void) {
+    s_persist_count = 0;
+}
+
+/*********************************** Heap *************************************/
+
+// last, so that everything above allocates through the counters like the modules under test do
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+static ShimHeapStats s_heap;
+
+void *shim_malloc(size_t size) {
+    s_heap.allocs++;
+    s_heap.bytes += size;
+    return malloc(size);
+}
+
+void *shim_calloc(size_t count, size_t size) {
+    s_heap.allocs++;
+    s_heap.bytes += count * size;
+    return calloc(count, size);
+}
+
+void *shim_realloc(void *ptr, size_t size) {
+    s_heap.allocs++;
+    s_heap.bytes += size;
+    return realloc(ptr, size);
+}
+
+void shim_free(void *ptr) {
+    if (ptr) {
+        s_heap.frees++;
+    }
+    free(ptr);
+}
+
+void shim_heap_reset(void) {
+    s_heap = (ShimHeapStats) { 0 };
+}
+
+ShimHeapStats shim_heap_stats(void) {
+    return s_heap;
+}
+
+size_t heap_bytes_used(void) {
+    return s_heap.bytes;
+}
+
+size_t heap_bytes_free(void) {
+    return 0;
+}
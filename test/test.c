@@ -0,0 +1,394 @@
+/**
+ * Unit tests for the modules built on the host; see Makefile. Each test is a function registered in TESTS below and
+ * a failed CHECK reports its line and carries on, so one run shows every failure.
+ */
+#include <pebble.h>
+
+#include "bg_chart.h"
+#include "bg_history.h"
+#include "bg_packet.h"
+#include "bg_store.h"
+#include "data-processor.h"
+#include "pebble_chart.h"
+
+static int s_failures = 0;
+
+#define CHECK(condition) do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            s_failures++; \
+        } \
+    } while (0)
+
+/****************************** data-processor ********************************/
+
+static void test_parse_int_array() {
+    char data[] = "120,-15,+7, 42";
+    ProcessingState state;
+    data_processor_init_state(&state, data, ',');
+    int values[8];
+    CHECK(data_processor_count(&state) == 4);
+    CHECK(data_processor_parse_int_array(&state, values, 8) == 4);
+    CHECK(values[0] == 120 && values[1] == -15 && values[2] == 7 && values[3] == 42);
+}
+
+static void test_parse_int_array_cap() {
+    char data[] = "1,2,3,4";
+    ProcessingState state;
+    data_processor_init_state(&state, data, ',');
+    int values[2];
+    CHECK(data_processor_parse_int_array(&state, values, 2) == 2);
+    CHECK(data_processor_get_int(&state) == 3);
+}
+
+static void test_trailing_delimiter() {
+    char data[] = "1,2,3,";
+    ProcessingState state;
+    data_processor_init_state(&state, data, ',');
+    int values[8];
+    CHECK(data_processor_count(&state) == 3);
+    CHECK(data_processor_parse_int_array(&state, values, 8) == 3);
+    CHECK(values[2] == 3);
+}
+
+static void test_parse_no_heap() {
+    char data[] = "1,2,3,4,5,6,7,8,9";
+    int values[9];
+    shim_heap_reset();
+    ProcessingState state;
+    data_processor_init_state(&state, data, ',');
+    data_processor_count(&state);
+    data_processor_parse_int_array(&state, values, 9);
+    CHECK(shim_heap_stats().allocs == 0);
+}
+
+static void test_empty_data() {
+    char data[] = "";
+    ProcessingState state;
+    data_processor_init_state(&state, data, ',');
+    int values[1];
+    CHECK(data_processor_count(&state) == 0);
+    CHECK(data_processor_parse_int_array(&state, values, 1) == 0);
+}
+
+/********************************* bg_packet **********************************/
+
+static Tuple *make_packet(uint8_t *buffer, uint8_t version, uint8_t count, uint8_t flags, uint32_t newest) {
+    uint8_t data[BG_PACKET_HEADER_SIZE + 255 * BG_PACKET_RECORD_SIZE] = {
+        version, count, flags, 0, newest & 0xFF, (newest >> 8) & 0xFF, (newest >> 16) & 0xFF, newest >> 24
+    };
+    for (int i = 0; i < count; i++) {
+        uint8_t *record = &data[BG_PACKET_HEADER_SIZE + i * BG_PACKET_RECORD_SIZE];
+        uint16_t minutes = i * 5;
+        int16_t mgdl = 100 + i;
+        record[0] = minutes & 0xFF;
+        record[1] = minutes >> 8;
+        record[2] = mgdl & 0xFF;
+        record[3] = (uint16_t) mgdl >> 8;
+    }
+    return shim_tuple_bytes(buffer, 7, data, BG_PACKET_HEADER_SIZE + count * BG_PACKET_RECORD_SIZE);
+}
+
+static void test_packet_parse() {
+    static uint8_t buffer[sizeof(Tuple) + 2048];
+    BgPacket packet;
+    CHECK(bg_packet_parse(&packet, make_packet(buffer, BG_PACKET_VERSION, 3, BG_PACKET_FLAG_FULL, 1700000000)));
+    CHECK(packet.count == 3 && packet.flags == BG_PACKET_FLAG_FULL && packet.newest == 1700000000);
+    uint16_t minutes;
+    int16_t mgdl;
+    bg_packet_get(&packet, 2, &minutes, &mgdl);
+    CHECK(minutes == 10 && mgdl == 102);
+}
+
+static void test_packet_rejects() {
+    static uint8_t buffer[sizeof(Tuple) + 2048];
+    BgPacket packet;
+    CHECK(!bg_packet_parse(&packet, NULL));
+    CHECK(!bg_packet_parse(&packet, make_packet(buffer, BG_PACKET_VERSION + 1, 1, 0, 0)));
+    Tuple *tuple = make_packet(buffer, BG_PACKET_VERSION, 4, 0, 0);
+    tuple->length -= 1;
+    CHECK(!bg_packet_parse(&packet, tuple));
+}
+
+/********************************* bg_history *********************************/
+
+static bool count_visit(const BgRecord *record, void *context) {
+    (*(int *) context)++;
+    return true;
+}
+
+static void test_history_order() {
+    bg_history_clear();
+    CHECK(bg_history_latest() == NULL);
+    CHECK(bg_history_append(600, 100));
+    CHECK(bg_history_append(900, 110));
+    CHECK(!bg_history_append(900, 120));
+    CHECK(!bg_history_append(300, 90));
+    CHECK(bg_history_count() == 2);
+    CHECK(bg_history_at(0)->time == 600 && bg_history_latest()->mgdl == 110);
+}
+
+static void test_history_wraps() {
+    bg_history_clear();
+    for (uint32_t i = 0; i < BG_HISTORY_CAPACITY + 10; i++) {
+        bg_history_append(i * 300, i);
+    }
+    CHECK(bg_history_count() == BG_HISTORY_CAPACITY);
+    CHECK(bg_history_at(0)->time == 10 * 300);
+    CHECK(bg_history_at(BG_HISTORY_CAPACITY) == NULL);
+    int visited = 0;
+    bg_history_foreach(20 * 300, 29 * 300, count_visit, &visited);
+    CHECK(visited == 10);
+}
+
+/********************************** bg_store **********************************/
+
+static void test_store_round_trip() {
+    shim_persist_reset();
+    bg_history_clear();
+    for (uint32_t i = 1; i <= 100; i++) {
+        bg_history_append(i * 300, 80 + i);
+    }
+    BgStoreState saved = { .trend = 4, .alert = 1, .egv = "181", .delta = "+3" };
+    bg_store_save(&saved);
+
+    bg_history_clear();
+    BgStoreState loaded;
+    CHECK(bg_store_load(&loaded));
+    CHECK(loaded.trend == 4 && loaded.alert == 1 && strcmp(loaded.egv, "181") == 0);
+    CHECK(bg_history_count() == BG_STORE_MAX_RECORDS);
+    CHECK(bg_history_latest()->time == 100 * 300 && bg_history_latest()->mgdl == 180);
+}
+
+/********************************* pebble_chart *******************************/
+
+static void test_chart_draws_and_frees() {
+    int x[96], y[96];
+    for (int i = 0; i < 96; i++) {
+        x[i] = i * 5;
+        y[i] = 100 + (i % 20) * 5;
+    }
+    shim_heap_reset();
+    ChartLayer *chart = chart_layer_create(GRect(0, 0, 144, 70));
+    chart_layer_animate(chart, false);
+    chart_layer_set_data(chart, x, eINT, y, eINT, 96);
+
+    GContext *ctx = shim_context_create();
+    shim_layer_render(chart_layer_get_layer(chart), ctx);
+    CHECK(shim_context_stats(ctx).lines > 0);
+
+    unsigned dirty = shim_layer_dirty_count(chart_layer_get_layer(chart));
+    chart_layer_append_point(chart, 96 * 5, 150);
+    CHECK(shim_layer_dirty_count(chart_layer_get_layer(chart)) > dirty);
+
+    shim_context_destroy(ctx);
+    chart_layer_destroy(chart);
+    ShimHeapStats heap = shim_heap_stats();
+    CHECK(heap.allocs == heap.frees);
+}
+
+#define CHART_WIDTH 136
+#define CHART_HEIGHT 62
+#define CHART_MARGIN 7
+#define CHART_WINDOW 180
+#define MAX_CHART_POINTS 400
+
+//! A chart set up like the one on the watch face.
+static ChartLayer *create_chart() {
+    ChartLayer *chart = chart_layer_create(GRect(0, 0, CHART_WIDTH, CHART_HEIGHT));
+    chart_layer_animate(chart, false);
+    chart_layer_set_margin(chart, CHART_MARGIN);
+    chart_layer_set_x_window(chart, CHART_WINDOW);
+    return chart;
+}
+
+//! Draws the chart and collects the vertices of the line it draws.
+static int chart_points(ChartLayer *chart, GPoint *points) {
+    GContext *ctx = shim_context_create();
+    shim_layer_render(chart_layer_get_layer(chart), ctx);
+    unsigned count;
+    const ShimLine *lines = shim_context_lines(ctx, &count);
+    int n = 0;
+    for (unsigned i = 0; i < count; i++) {
+        points[n++] = lines[i].p0;
+    }
+    if (count) {
+        points[n++] = lines[count - 1].p1;
+    }
+    shim_context_destroy(ctx);
+    return n;
+}
+
+static bool same_points(const GPoint *a, int count_a, const GPoint *b, int count_b) {
+    if (count_a != count_b) {
+        return false;
+    }
+    for (int i = 0; i < count_a; i++) {
+        if (a[i].x != b[i].x || a[i].y != b[i].y) {
+            fprintf(stderr, "point %d: (%d, %d) != (%d, %d)\n", i, a[i].x, a[i].y, b[i].x, b[i].y);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Appends readings one by one, first within the window and then sliding it along with a new high and a new low, and
+ * checks each time that the chart matches a full layout of the readings left in the window.
+ */
+static void test_chart_append_matches_set_data() {
+    int x[60], y[60];
+    for (int i = 0; i < 60; i++) {
+        x[i] = 28000000 + i * 5;
+        y[i] = 110 + (i * 37) % 60;
+    }
+    y[40] = 250;
+    y[50] = 60;
+
+    ChartLayer *appended = create_chart();
+    chart_layer_set_data(appended, x, eINT, y, eINT, 20);
+    GPoint drawn[MAX_CHART_POINTS], expected[MAX_CHART_POINTS];
+    chart_points(appended, drawn);
+
+    for (int n = 21; n <= 60; n++) {
+        chart_layer_append_point(appended, x[n - 1], y[n - 1]);
+        int first = 0;
+        while (x[first] <= x[n - 1] - CHART_WINDOW) {
+            first++;
+        }
+        ChartLayer *full = create_chart();
+        chart_layer_set_data(full, x + first, eINT, y + first, eINT, n - first);
+        int count = chart_points(appended, drawn);
+        CHECK(count == n - first);
+        CHECK(same_points(drawn, count, expected, chart_points(full, expected)));
+        chart_layer_destroy(full);
+    }
+    chart_layer_destroy(appended);
+}
+
+/**
+ * More readings than pixel columns: each column is cut down to its lowest and highest reading, so a one reading spike
+ * and dip both still show, at the top and bottom of the plot.
+ */
+static void test_chart_decimation_keeps_extremes() {
+    int x[300], y[300];
+    for (int i = 0; i < 300; i++) {
+        x[i] = i;
+        y[i] = 120;
+    }
+    y[100] = 300;
+    y[201] = 45;
+
+    ChartLayer *chart = chart_layer_create(GRect(0, 0, CHART_WIDTH, CHART_HEIGHT));
+    chart_layer_animate(chart, false);
+    chart_layer_set_margin(chart, CHART_MARGIN);
+    chart_layer_set_data(chart, x, eINT, y, eINT, 300);
+    GPoint points[MAX_CHART_POINTS];
+    int count = chart_points(chart, points);
+    CHECK(count > 0 && count < 300);
+
+    int top = CHART_HEIGHT, bottom = 0;
+    for (int i = 0; i < count; i++) {
+        top = points[i].y < top ? points[i].y : top;
+        bottom = points[i].y > bottom ? points[i].y : bottom;
+    }
+    CHECK(top == CHART_MARGIN);
+    CHECK(bottom == CHART_HEIGHT - CHART_MARGIN);
+    chart_layer_destroy(chart);
+}
+
+/**
+ * The lowest and highest reading land on the bottom and top margins, whatever the span between them.
+ */
+static void test_chart_range_fills_plot() {
+    static const int SPANS[][2] = { { 100, 130 }, { 70, 180 }, { 39, 401 }, { 95, 97 } };
+    for (size_t s = 0; s < ARRAY_LENGTH(SPANS); s++) {
+        int x[] = { 0, 5, 10, 15 };
+        int y[] = { SPANS[s][0], SPANS[s][1], (SPANS[s][0] + SPANS[s][1]) / 2, SPANS[s][0] };
+        ChartLayer *chart = create_chart();
+        chart_layer_set_data(chart, x, eINT, y, eINT, 4);
+        GPoint points[MAX_CHART_POINTS];
+        int count = chart_points(chart, points);
+        CHECK(count == 4);
+        if (SPANS[s][1] - SPANS[s][0] >= 30) {
+            CHECK(points[0].y == CHART_HEIGHT - CHART_MARGIN);
+            CHECK(points[1].y == CHART_MARGIN);
+        } else {
+            // narrow ranges are widened around the readings, so they sit inside the margins
+            CHECK(points[0].y < CHART_HEIGHT - CHART_MARGIN && points[1].y > CHART_MARGIN);
+        }
+        CHECK(points[3].y == points[0].y);
+        // the window ends at the newest reading
+        CHECK(points[3].x >= CHART_WIDTH - CHART_MARGIN - 1 && points[3].x <= CHART_WIDTH - CHART_MARGIN);
+        chart_layer_destroy(chart);
+    }
+}
+
+/********************************** bg_chart **********************************/
+
+/**
+ * A full packet rebuilds the chart from the history, a later one is appended to both, and one with nothing to append
+ * to is left for a full resync. make_packet puts readings 5 minutes apart, going up by 1 mg/dL.
+ */
+static void test_bg_chart_packets() {
+    static uint8_t buffer[sizeof(Tuple) + 2048];
+    ChartLayer *chart = create_chart();
+    GPoint points[MAX_CHART_POINTS];
+    BgPacket packet;
+
+    bg_history_clear();
+    bg_packet_parse(&packet, make_packet(buffer, BG_PACKET_VERSION, 3, 0, 1700000000));
+    CHECK(!bg_chart_apply_packet(chart, &packet));
+    CHECK(bg_history_count() == 0);
+
+    bg_packet_parse(&packet, make_packet(buffer, BG_PACKET_VERSION, 10, BG_PACKET_FLAG_FULL, 1700000000));
+    CHECK(bg_chart_apply_packet(chart, &packet));
+    bg_chart_refresh(chart);
+    CHECK(bg_history_count() == 10);
+    CHECK(chart_points(chart, points) == 10);
+
+    bg_packet_parse(&packet, make_packet(buffer, BG_PACKET_VERSION, 2, 0, 1700000000 + 600));
+    CHECK(!bg_chart_apply_packet(chart, &packet));
+    CHECK(bg_history_count() == 12);
+    CHECK(chart_points(chart, points) == 12);
+
+    // past the chart window only the readings within it are charted
+    bg_packet_parse(&packet, make_packet(buffer, BG_PACKET_VERSION, 60, BG_PACKET_FLAG_FULL, 1700100000));
+    CHECK(bg_chart_apply_packet(chart, &packet));
+    bg_chart_refresh(chart);
+    CHECK(chart_points(chart, points) == BG_CHART_WINDOW_MINUTES / 5);
+    chart_layer_destroy(chart);
+}
+
+/************************************ Main ************************************/
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} TESTS[] = {
+    { "parse_int_array", test_parse_int_array },
+    { "parse_int_array_cap", test_parse_int_array_cap },
+    { "trailing_delimiter", test_trailing_delimiter },
+    { "parse_no_heap", test_parse_no_heap },
+    { "empty_data", test_empty_data },
+    { "packet_parse", test_packet_parse },
+    { "packet_rejects", test_packet_rejects },
+    { "history_order", test_history_order },
+    { "history_wraps", test_history_wraps },
+    { "store_round_trip", test_store_round_trip },
+    { "chart_draws_and_frees", test_chart_draws_and_frees },
+    { "chart_append_matches_set_data", test_chart_append_matches_set_data },
+    { "chart_decimation_keeps_extremes", test_chart_decimation_keeps_extremes },
+    { "chart_range_fills_plot", test_chart_range_fills_plot },
+    { "bg_chart_packets", test_bg_chart_packets },
+};
+
+int main(void) {
+    for (size_t i = 0; i < ARRAY_LENGTH(TESTS); i++) {
+        int before = s_failures;
+        TESTS[i].run();
+        printf("%-32s %s\n", TESTS[i].name, s_failures == before ? "ok" : "FAILED");
+    }
+    printf("%d failure(s)\n", s_failures);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,272 @@
+/**
+ * Builds resources/images/bg_glyphs.png and src/bg_glyph_table.h, the pre-rendered glyphs the watch face draws the
+ * BG reading with, from the same font and size as FONT_HN_BOLD_48.
+ *
+ * Each glyph is rendered to 1 bit, white on clear, into a cell of its own. The cells are stacked vertically so every
+ * glyph stays byte aligned on aplite, just like the trend icon atlas. The glyphs cover the readings and the status
+ * words sent in their place ("old", "hgh", "low", "log", "???"); anything else is left to the font.
+ *
+ * Only reads TrueType outlines, the kind of font in resources/fonts. Uses nothing but node itself.
+ */
+var fs = require('fs');
+var path = require('path');
+var png = require('./png.js');
+
+var FONT = path.join(__dirname, '..', 'resources', 'fonts', 'HelveticaNeueBold.ttf');
+var IMAGE = path.join(__dirname, '..', 'resources', 'images', 'bg_glyphs.png');
+var TABLE = path.join(__dirname, '..', 'src', 'bg_glyph_table.h');
+var PIXEL_SIZE = 48;
+var CHARS = '0123456789.?dghlow';
+var SAMPLES = 4;        // per pixel, in each direction
+
+function readTables(data) {
+    var tables = {};
+    for (var i = 0, count = data.readUInt16BE(4); i < count; i++) {
+        var record = 12 + i * 16;
+        tables[data.toString('ascii', record, record + 4)] = data.readUInt32BE(record + 8);
+    }
+    return tables;
+}
+
+/**
+ * Maps a character to its glyph index through the format 4 (BMP) cmap subtable.
+ */
+function glyphIndex(data, tables, code) {
+    var cmap = tables.cmap;
+    for (var i = 0, count = data.readUInt16BE(cmap + 2); i < count; i++) {
+        var subtable = cmap + data.readUInt32BE(cmap + 4 + i * 8 + 4);
+        if (data.readUInt16BE(subtable) !== 4) {
+            continue;
+        }
+        var segments = data.readUInt16BE(subtable + 6) / 2;
+        var ends = subtable + 14, starts = ends + segments * 2 + 2;
+        var deltas = starts + segments * 2, offsets = deltas + segments * 2;
+        for (var s = 0; s < segments; s++) {
+            var start = data.readUInt16BE(starts + s * 2);
+            if (code < start || code > data.readUInt16BE(ends + s * 2)) {
+                continue;
+            }
+            var delta = data.readInt16BE(deltas + s * 2), rangeOffset = data.readUInt16BE(offsets + s * 2);
+            if (rangeOffset === 0) {
+                return (code + delta) & 0xFFFF;
+            }
+            var glyph = data.readUInt16BE(offsets + s * 2 + rangeOffset + (code - start) * 2);
+            return glyph ? (glyph + delta) & 0xFFFF : 0;
+        }
+    }
+    throw new Error('no glyph for ' + String.fromCharCode(code));
+}
+
+/**
+ * Reads the contours of a glyph as lists of {x, y, on} points in font units, following composite glyphs.
+ */
+function readContours(data, tables, glyph) {
+    var longOffsets = data.readInt16BE(tables.head + 50) === 1;
+    var start = longOffsets ? data.readUInt32BE(tables.loca + glyph * 4) : data.readUInt16BE(tables.loca + glyph * 2) * 2;
+    var end = longOffsets ? data.readUInt32BE(tables.loca + glyph * 4 + 4) : data.readUInt16BE(tables.loca + glyph * 2 + 2) * 2;
+    if (start === end) {
+        return [];
+    }
+    var offset = tables.glyf + start;
+    var contourCount = data.readInt16BE(offset);
+    offset += 10;
+
+    if (contourCount < 0) {
+        var contours = [], flags;
+        do {
+            flags = data.readUInt16BE(offset);
+            var component = data.readUInt16BE(offset + 2);
+            var dx, dy;
+            if (flags & 1) {
+                dx = data.readInt16BE(offset + 4);
+                dy = data.readInt16BE(offset + 6);
+                offset += 8;
+            } else {
+                dx = data.readInt8(offset + 4);
+                dy = data.readInt8(offset + 5);
+                offset += 6;
+            }
+            offset += (flags & 8) ? 2 : (flags & 0x40) ? 4 : (flags & 0x80) ? 8 : 0;
+            readContours(data, tables, component).forEach(function (contour) {
+                contours.push(contour.map(function (p) {
+                    return { x: p.x + dx, y: p.y + dy, on: p.on };
+                }));
+            });
+        } while (flags & 0x20);
+        return contours;
+    }
+
+    var endPoints = [];
+    for (var c = 0; c < contourCount; c++) {
+        endPoints.push(data.readUInt16BE(offset + c * 2));
+    }
+    offset += contourCount * 2;
+    offset += 2 + data.readUInt16BE(offset);
+    var pointCount = endPoints[contourCount - 1] + 1, pointFlags = [];
+    while (pointFlags.length < pointCount) {
+        var flag = data[offset++];
+        pointFlags.push(flag);
+        if (flag & 8) {
+            for (var repeat = data[offset++]; repeat > 0; repeat--) {
+                pointFlags.push(flag);
+            }
+        }
+    }
+    function readCoordinates(shortBit, sameBit) {
+        var values = [], value = 0;
+        pointFlags.forEach(function (f) {
+            if (f & shortBit) {
+                value += (f & sameBit) ? data[offset] : -data[offset];
+                offset += 1;
+            } else if (!(f & sameBit)) {
+                value += data.readInt16BE(offset);
+                offset += 2;
+            }
+            values.push(value);
+        });
+        return values;
+    }
+    var xs = readCoordinates(2, 16), ys = readCoordinates(4, 32);
+
+    var result = [], first = 0;
+    endPoints.forEach(function (last) {
+        var contour = [];
+        for (var i = first; i <= last; i++) {
+            contour.push({ x: xs[i], y: ys[i], on: (pointFlags[i] & 1) === 1 });
+        }
+        result.push(contour);
+        first = last + 1;
+    });
+    return result;
+}
+
+/**
+ * Flattens a contour of on and off curve points into line segments in pixels, y down from the baseline.
+ */
+function flatten(contour, scale) {
+    var points = [];
+    contour.forEach(function (p, i) {
+        var next = contour[(i + 1) % contour.length];
+        points.push(p);
+        if (!p.on && !next.on) {
+            points.push({ x: (p.x + next.x) / 2, y: (p.y + next.y) / 2, on: true });
+        }
+    });
+    var start = points.findIndex(function (p) {
+        return p.on;
+    });
+    points = points.slice(start).concat(points.slice(0, start));
+
+    var lines = [], from = points[0];
+    for (var i = 1; i <= points.length; i++) {
+        var p = points[i % points.length];
+        if (p.on) {
+            lines.push([from, p]);
+            from = p;
+            continue;
+        }
+        var to = points[(i + 1) % points.length];
+        var previous = from;
+        for (var step = 1; step <= 8; step++) {
+            var t = step / 8, u = 1 - t;
+            var point = { x: u * u * from.x + 2 * u * t * p.x + t * t * to.x,
+                          y: u * u * from.y + 2 * u * t * p.y + t * t * to.y };
+            lines.push([previous, point]);
+            previous = point;
+        }
+        from = to;
+        i++;
+    }
+    return lines.map(function (line) {
+        return line.map(function (p) {
+            return { x: p.x * scale, y: -p.y * scale };
+        });
+    });
+}
+
+/**
+ * Whether the point is inside the outline, by the non-zero winding rule.
+ */
+function inside(lines, x, y) {
+    var winding = 0;
+    lines.forEach(function (line) {
+        var a = line[0], b = line[1];
+        if ((a.y <= y) !== (b.y <= y)) {
+            var crossing = a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y);
+            if (crossing > x) {
+                winding += a.y < b.y ? 1 : -1;
+            }
+        }
+    });
+    return winding !== 0;
+}
+
+module.exports = function () {
+    var data = fs.readFileSync(FONT);
+    var tables = readTables(data);
+    var scale = PIXEL_SIZE / data.readUInt16BE(tables.head + 18);
+    var metricCount = data.readUInt16BE(tables.hhea + 34);
+
+    var glyphs = CHARS.split('').map(function (ch) {
+        var index = glyphIndex(data, tables, ch.charCodeAt(0));
+        var advance = data.readUInt16BE(tables.hmtx + Math.min(index, metricCount - 1) * 4);
+        var lines = [].concat.apply([], readContours(data, tables, index).map(function (contour) {
+            return flatten(contour, scale);
+        }));
+        var ys = [].concat.apply([], lines).map(function (p) {
+            return p.y;
+        });
+        return {
+            lines: lines,
+            advance: Math.round(advance * scale),
+            top: Math.floor(Math.min.apply(null, ys)),
+            bottom: Math.ceil(Math.max.apply(null, ys))
+        };
+    });
+
+    var ascent = -Math.min.apply(null, glyphs.map(function (g) { return g.top; }));
+    var height = ascent + Math.max.apply(null, glyphs.map(function (g) { return g.bottom; }));
+    var width = Math.max.apply(null, glyphs.map(function (g) { return g.advance; }));
+
+    var rows = [];
+    glyphs.forEach(function (glyph) {
+        for (var y = 0; y < height; y++) {
+            var row = Buffer.alloc(width * png.BYTES_PER_PIXEL);
+            for (var x = 0; x < width; x++) {
+                var covered = 0;
+                for (var sy = 0; sy < SAMPLES; sy++) {
+                    for (var sx = 0; sx < SAMPLES; sx++) {
+                        if (inside(glyph.lines, x + (sx + 0.5) / SAMPLES, y - ascent + (sy + 0.5) / SAMPLES)) {
+                            covered++;
+                        }
+                    }
+                }
+                if (covered * 2 >= SAMPLES * SAMPLES) {
+                    row.fill(0xFF, x * png.BYTES_PER_PIXEL, (x + 1) * png.BYTES_PER_PIXEL);
+                }
+            }
+            rows.push(row);
+        }
+    });
+    png.writePng(IMAGE, width, rows);
+
+    fs.writeFileSync(TABLE, [
+        '// Generated by tools/bg-glyphs.js from ' + path.basename(FONT) + ' at ' + PIXEL_SIZE + 'px; do not edit.',
+        '#pragma once',
+        '',
+        '#define BG_GLYPH_CHARS "' + CHARS + '"',
+        '#define BG_GLYPH_COUNT ' + CHARS.length,
+        '#define BG_GLYPH_CELL_WIDTH ' + width,
+        '#define BG_GLYPH_CELL_HEIGHT ' + height,
+        '',
+        '//! The advance of each glyph in BG_GLYPH_CHARS, in pixels.',
+        'static const uint8_t BG_GLYPH_ADVANCES[BG_GLYPH_COUNT] = {',
+        '    ' + glyphs.map(function (g) { return g.advance; }).join(', '),
+        '};',
+        ''
+    ].join('\n'));
+};
+
+if (require.main === module) {
+    module.exports();
+}
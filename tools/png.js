@@ -0,0 +1,95 @@
+/**
+ * Minimal PNG reading and writing for the resource build steps in tools/. Only handles 8-bit RGBA, non-interlaced
+ * images, which is what the resources are saved as. Uses nothing but node's own zlib.
+ */
+var fs = require('fs');
+var zlib = require('zlib');
+
+var BYTES_PER_PIXEL = 4;
+
+function crc32(buffer) {
+    var crc = -1;
+    for (var i = 0; i < buffer.length; i++) {
+        crc ^= buffer[i];
+        for (var k = 0; k < 8; k++) {
+            crc = (crc >>> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return (crc ^ -1) >>> 0;
+}
+
+function chunk(type, data) {
+    var length = Buffer.alloc(4);
+    length.writeUInt32BE(data.length, 0);
+    var body = Buffer.concat([Buffer.from(type, 'ascii'), data]);
+    var crc = Buffer.alloc(4);
+    crc.writeUInt32BE(crc32(body), 0);
+    return Buffer.concat([length, body, crc]);
+}
+
+function paeth(a, b, c) {
+    var p = a + b - c, pa = Math.abs(p - a), pb = Math.abs(p - b), pc = Math.abs(p - c);
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+}
+
+/**
+ * Decodes a PNG into its width, height and unfiltered RGBA rows.
+ */
+function readPng(file) {
+    var data = fs.readFileSync(file);
+    var width = data.readUInt32BE(16), height = data.readUInt32BE(20);
+    if (data[24] !== 8 || data[25] !== 6 || data[28] !== 0) {
+        throw new Error(file + ': expected an 8-bit RGBA, non-interlaced PNG');
+    }
+
+    var idat = [];
+    for (var offset = 8; offset < data.length; ) {
+        var length = data.readUInt32BE(offset);
+        if (data.toString('ascii', offset + 4, offset + 8) === 'IDAT') {
+            idat.push(data.slice(offset + 8, offset + 8 + length));
+        }
+        offset += 12 + length;
+    }
+    var raw = zlib.inflateSync(Buffer.concat(idat));
+
+    var stride = width * BYTES_PER_PIXEL, rows = [], previous = Buffer.alloc(stride);
+    for (var y = 0; y < height; y++) {
+        var filter = raw[y * (stride + 1)];
+        var row = Buffer.from(raw.slice(y * (stride + 1) + 1, (y + 1) * (stride + 1)));
+        for (var x = 0; x < stride; x++) {
+            var left = x >= BYTES_PER_PIXEL ? row[x - BYTES_PER_PIXEL] : 0;
+            var up = previous[x];
+            var upLeft = x >= BYTES_PER_PIXEL ? previous[x - BYTES_PER_PIXEL] : 0;
+            var predictor = [0, left, up, (left + up) >> 1, paeth(left, up, upLeft)][filter];
+            row[x] = (row[x] + predictor) & 0xFF;
+        }
+        rows.push(row);
+        previous = row;
+    }
+    return { width: width, height: height, rows: rows };
+}
+
+function writePng(file, width, rows) {
+    var header = Buffer.alloc(13);
+    header.writeUInt32BE(width, 0);
+    header.writeUInt32BE(rows.length, 4);
+    header[8] = 8;  // bit depth
+    header[9] = 6;  // RGBA
+    header[10] = header[11] = header[12] = 0;
+
+    var raw = Buffer.concat(rows.map(function (row) {
+        return Buffer.concat([Buffer.from([0]), row]);
+    }));
+    fs.writeFileSync(file, Buffer.concat([
+        Buffer.from([0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A]),
+        chunk('IHDR', header),
+        chunk('IDAT', zlib.deflateSync(raw, { level: 9 })),
+        chunk('IEND', Buffer.alloc(0))
+    ]));
+}
+
+module.exports = {
+    BYTES_PER_PIXEL: BYTES_PER_PIXEL,
+    readPng: readPng,
+    writePng: writePng
+};
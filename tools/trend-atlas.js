@@ -0,0 +1,30 @@
+/**
+ * Builds resources/images/trends.png, the trend icon atlas loaded by the watch face on aplite, by stacking the
+ * individual 30x30 icons vertically in the order of the TREND_ICON_* values in src/main.c. Vertical stacking keeps
+ * every icon on whole rows, so sub-bitmaps stay byte aligned on the 1-bit platforms. Colour platforms draw the same
+ * icons as vector glyphs traced by tools/trend-pdc.js instead.
+ */
+var path = require('path');
+var png = require('./png.js');
+
+var ICONS = ['none', 'upup', 'up', 'up45', 'flat', 'down45', 'down', 'downdown', 'refresh'];
+var IMAGES = path.join(__dirname, '..', 'resources', 'images');
+
+module.exports = function () {
+    var icons = ICONS.map(function (name) {
+        return png.readPng(path.join(IMAGES, name + '.png'));
+    });
+    var width = icons[0].width;
+    icons.forEach(function (icon, index) {
+        if (icon.width !== width || icon.height !== icons[0].height) {
+            throw new Error(ICONS[index] + '.png: all icons must be the same size');
+        }
+    });
+    png.writePng(path.join(IMAGES, 'trends.png'), width, [].concat.apply([], icons.map(function (icon) {
+        return icon.rows;
+    })));
+};
+
+if (require.main === module) {
+    module.exports();
+}
@@ -0,0 +1,238 @@
+/**
+ * Builds resources/images/trends.pdc, the trend glyphs drawn by the watch face on colour platforms, as a Pebble draw
+ * command sequence with one frame per icon in the order of the TREND_ICON_* values in src/main.c: the trend values
+ * sent by the phone, then TREND_ICON_REFRESH.
+ *
+ * The outlines are traced from the same 30x30 icons in resources/images that tools/trend-atlas.js stacks into the png
+ * atlas used on aplite, so both stay in step with the art: edit the pngs and rerun both. Each shape becomes one filled
+ * path along its pixel edges, with any holes joined in through a cut, simplified to within TOLERANCE of those edges.
+ * Every command is drawn white; the watch face repaints them in the colour of the BG text before drawing.
+ */
+var fs = require('fs');
+var path = require('path');
+var png = require('./png.js');
+
+var ICONS = ['none', 'upup', 'up', 'up45', 'flat', 'down45', 'down', 'downdown', 'refresh'];
+var IMAGES = path.join(__dirname, '..', 'resources', 'images');
+var OUTPUT = path.join(IMAGES, 'trends.pdc');
+var TOLERANCE = 0.5;    // how far, in pixels, a simplified outline may stray from the pixel edges
+
+var WHITE = 0xFF;   // GColor8, argb 2 bits each
+var CLEAR = 0x00;
+
+var PATH = 1;
+
+/**
+ * Reads an icon as rows of booleans, set where the pixel is opaque.
+ */
+function readMask(name) {
+    var image = png.readPng(path.join(IMAGES, name + '.png'));
+    return image.rows.map(function (row) {
+        var mask = [];
+        for (var x = 0; x < image.width; x++) {
+            mask.push(row[x * png.BYTES_PER_PIXEL + 3] >= 0x80);
+        }
+        return mask;
+    });
+}
+
+/**
+ * Follows the pixel edges between set and clear pixels into closed loops of corner points. Outlines run clockwise
+ * and holes anticlockwise (y down). Where two shapes touch at a corner they are kept apart.
+ */
+function traceLoops(mask) {
+    var set = function (x, y) {
+        return y >= 0 && y < mask.length && x >= 0 && x < mask[y].length && mask[y][x];
+    };
+    var edges = {};
+    var add = function (x0, y0, x1, y1) {
+        var key = x0 + ',' + y0;
+        (edges[key] = edges[key] || []).push({ from: [x0, y0], to: [x1, y1] });
+    };
+    mask.forEach(function (row, y) {
+        row.forEach(function (on, x) {
+            if (!on) {
+                return;
+            }
+            if (!set(x, y - 1)) add(x, y, x + 1, y);
+            if (!set(x + 1, y)) add(x + 1, y, x + 1, y + 1);
+            if (!set(x, y + 1)) add(x + 1, y + 1, x, y + 1);
+            if (!set(x - 1, y)) add(x, y + 1, x, y);
+        });
+    });
+
+    var loops = [];
+    Object.keys(edges).forEach(function (key) {
+        while (edges[key].length) {
+            var edge = edges[key].pop(), loop = [];
+            while (edge) {
+                loop.push(edge.from);
+                var next = edges[edge.to[0] + ',' + edge.to[1]];
+                if (!next || !next.length) {
+                    break;
+                }
+                // at a corner shared by two shapes, turn right so each loop keeps to its own shape
+                var dx = edge.to[0] - edge.from[0], dy = edge.to[1] - edge.from[1];
+                var turn = next.findIndex(function (e) {
+                    return e.to[0] - e.from[0] === -dy && e.to[1] - e.from[1] === dx;
+                });
+                edge = next.splice(turn < 0 ? 0 : turn, 1)[0];
+            }
+            loops.push(loop);
+        }
+    });
+    return loops;
+}
+
+function area(loop) {
+    var sum = 0;
+    loop.forEach(function (p, i) {
+        var q = loop[(i + 1) % loop.length];
+        sum += p[0] * q[1] - q[0] * p[1];
+    });
+    return sum / 2;
+}
+
+function contains(loop, x, y) {
+    var inside = false;
+    for (var i = 0, j = loop.length - 1; i < loop.length; j = i++) {
+        var a = loop[i], b = loop[j];
+        if ((a[1] > y) !== (b[1] > y) && x < (b[0] - a[0]) * (y - a[1]) / (b[1] - a[1]) + a[0]) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+function distance(p, a, b) {
+    var dx = b[0] - a[0], dy = b[1] - a[1], length = dx * dx + dy * dy;
+    var t = length ? Math.max(0, Math.min(1, ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / length)) : 0;
+    return Math.sqrt(Math.pow(a[0] + t * dx - p[0], 2) + Math.pow(a[1] + t * dy - p[1], 2));
+}
+
+/**
+ * Douglas-Peucker on the open run of points from `first` to `last`.
+ */
+function simplifyRun(points, first, last, keep) {
+    var farthest = -1, worst = TOLERANCE;
+    for (var i = first + 1; i < last; i++) {
+        var d = distance(points[i], points[first], points[last]);
+        if (d > worst) {
+            farthest = i;
+            worst = d;
+        }
+    }
+    if (farthest >= 0) {
+        keep[farthest] = true;
+        simplifyRun(points, first, farthest, keep);
+        simplifyRun(points, farthest, last, keep);
+    }
+}
+
+/**
+ * Simplifies a closed loop, split at its first point and the point farthest from it.
+ */
+function simplify(loop) {
+    var far = 0;
+    loop.forEach(function (p, i) {
+        if (distance(p, loop[0], loop[0]) > distance(loop[far], loop[0], loop[0])) {
+            far = i;
+        }
+    });
+    var points = loop.concat([loop[0]]);
+    var keep = points.map(function () { return false; });
+    keep[0] = keep[far] = true;
+    simplifyRun(points, 0, far, keep);
+    simplifyRun(points, far, loop.length, keep);
+    return loop.filter(function (p, i) {
+        return keep[i];
+    });
+}
+
+/**
+ * Joins the holes into their outline through a cut from each hole's first point to the nearest point of the outline.
+ * The cut runs both ways, so it cancels out when the path is filled.
+ */
+function joinHoles(outline, holes) {
+    var path = outline.slice();
+    holes.forEach(function (hole) {
+        var nearest = 0;
+        path.forEach(function (p, i) {
+            if (distance(hole[0], p, p) < distance(hole[0], path[nearest], path[nearest])) {
+                nearest = i;
+            }
+        });
+        path = path.slice(0, nearest + 1).concat(hole, [hole[0]], path.slice(nearest));
+    });
+    return path;
+}
+
+/**
+ * Traces an icon into filled paths, one per shape.
+ */
+function traceIcon(name) {
+    var loops = traceLoops(readMask(name));
+    var outlines = loops.filter(function (loop) { return area(loop) > 0; });
+    var holes = loops.filter(function (loop) { return area(loop) < 0; });
+    return outlines.map(function (outline) {
+        var inner = holes.filter(function (hole) {
+            // a hole belongs to the smallest outline around it
+            var around = outlines.filter(function (o) {
+                return contains(o, hole[0][0] + 0.5, hole[0][1] + 0.25);
+            });
+            around.sort(function (a, b) { return area(a) - area(b); });
+            return around[0] === outline;
+        });
+        return {
+            type: PATH, open: false, stroke: CLEAR, width: 0, fill: WHITE,
+            points: joinHoles(simplify(outline), inner.map(simplify))
+        };
+    });
+}
+
+function command(c) {
+    var buffer = Buffer.alloc(9 + c.points.length * 4);
+    buffer.writeUInt8(c.type, 0);
+    buffer.writeUInt8(0, 1);                    // flags: not hidden
+    buffer.writeUInt8(c.stroke, 2);
+    buffer.writeUInt8(c.width, 3);
+    buffer.writeUInt8(c.fill, 4);
+    buffer.writeUInt16LE(c.open ? 1 : 0, 5);    // open path flag, or the radius of a circle
+    buffer.writeUInt16LE(c.points.length, 7);
+    c.points.forEach(function (p, i) {
+        buffer.writeInt16LE(p[0], 9 + i * 4);
+        buffer.writeInt16LE(p[1], 11 + i * 4);
+    });
+    return buffer;
+}
+
+function frame(commands) {
+    var header = Buffer.alloc(4);
+    header.writeUInt16LE(1, 0);                 // duration, unused since the sequence is never played
+    header.writeUInt16LE(commands.length, 2);
+    return Buffer.concat([header].concat(commands.map(command)));
+}
+
+module.exports = function () {
+    var size = readMask(ICONS[0]).length;
+    var frames = ICONS.map(traceIcon);
+
+    var header = Buffer.alloc(8);
+    header.writeUInt8(1, 0);                    // version
+    header.writeUInt8(0, 1);
+    header.writeInt16LE(size, 2);               // view box
+    header.writeInt16LE(size, 4);
+    header.writeUInt16LE(1, 6);                 // play count
+    var frameCount = Buffer.alloc(2);
+    frameCount.writeUInt16LE(frames.length, 0);
+    var body = Buffer.concat([header, frameCount].concat(frames.map(frame)));
+
+    var magic = Buffer.alloc(8);
+    magic.write('PDCS', 0, 'ascii');
+    magic.writeUInt32LE(body.length, 4);
+    fs.writeFileSync(OUTPUT, Buffer.concat([magic, body]));
+};
+
+if (require.main === module) {
+    module.exports();
+}